@@ -0,0 +1,173 @@
+#include "BufferPool.h"
+#include "ReadStats.h"
+
+#include <map>
+#include <vector>
+#include <mutex>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace MedImageParser
+{
+
+static const size_t pageSize = 4096; 
+static const size_t hugePageSize = 2 * 1024 * 1024; 
+
+//sizes are rounded up, so that nearby requests share a bucket: 
+static size_t BucketSize(size_t length)
+{
+    size_t granularity = (length >= hugePageSize) ? hugePageSize : pageSize; 
+    return (length + granularity - 1) / granularity * granularity; 
+}
+
+static void* AllocateBlock(size_t bucket)
+{
+#ifndef _WIN32
+    if(bucket >= hugePageSize){
+        void *block = mmap(NULL, bucket, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); 
+        if(block == MAP_FAILED){
+            return NULL; 
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(block, bucket, MADV_HUGEPAGE); 
+#endif
+        return block; 
+    }
+#endif
+    return ::operator new(bucket, std::nothrow); 
+}
+
+static void FreeBlock(void *block, size_t bucket)
+{
+#ifndef _WIN32
+    if(bucket >= hugePageSize){
+        munmap(block, bucket); 
+        return; 
+    }
+#endif
+    ::operator delete(block); 
+}
+
+class BufferPool{
+public:
+    BufferPool(){
+        limit = static_cast<size_t>(1) << 30; 
+        idleBytes = 0; 
+    }
+
+    void* Take(size_t bucket, bool& isReused){
+        isReused = true; 
+        {
+            std::lock_guard<std::mutex> lock(mutex); 
+            std::map<size_t, std::vector<void*> >::iterator found = idle.find(bucket); 
+            if(found != idle.end() && !found->second.empty()){
+                void *block = found->second.back(); 
+                found->second.pop_back(); 
+                idleBytes -= bucket; 
+                return block; 
+            }
+        }
+        isReused = false; 
+        return AllocateBlock(bucket); 
+    }
+
+    void Give(void *block, size_t bucket){
+        {
+            std::lock_guard<std::mutex> lock(mutex); 
+            if(idleBytes + bucket <= limit){
+                idle[bucket].push_back(block); 
+                idleBytes += bucket; 
+                return; 
+            }
+        }
+        FreeBlock(block, bucket); 
+    }
+
+    void SetLimit(size_t bytes){
+        std::lock_guard<std::mutex> lock(mutex); 
+        limit = bytes; 
+        Trim(); 
+    }
+
+    size_t GetLimit(){
+        std::lock_guard<std::mutex> lock(mutex); 
+        return limit; 
+    }
+
+    void Clear(){
+        std::lock_guard<std::mutex> lock(mutex); 
+        size_t keep = limit; 
+        limit = 0; 
+        Trim(); 
+        limit = keep; 
+    }
+
+private:
+    //largest buckets go first, caller holds the lock: 
+    void Trim(){
+        while(idleBytes > limit && !idle.empty()){
+            std::map<size_t, std::vector<void*> >::iterator largest = --idle.end(); 
+            while(!largest->second.empty() && idleBytes > limit){
+                FreeBlock(largest->second.back(), largest->first); 
+                largest->second.pop_back(); 
+                idleBytes -= largest->first; 
+            }
+            if(largest->second.empty()){
+                idle.erase(largest); 
+            }
+        }
+    }
+
+    std::mutex mutex; 
+    std::map<size_t, std::vector<void*> > idle; 
+    size_t idleBytes; 
+    size_t limit; 
+}; 
+
+//never destroyed, buffers may be released during static destruction: 
+static BufferPool& Pool()
+{
+    static BufferPool *pool = new BufferPool; 
+    return *pool; 
+}
+
+struct PooledBufferDeleter{
+    size_t bucket; 
+    void operator()(unsigned char *block) const{
+        Pool().Give(block, bucket); 
+    }
+}; 
+
+std::shared_ptr<unsigned char> AcquireBuffer(size_t length)
+{
+    PooledBufferDeleter deleter; 
+    deleter.bucket = BucketSize(length > 0 ? length : 1); 
+
+    bool isReused = false; 
+    unsigned char *block = static_cast<unsigned char*>(Pool().Take(deleter.bucket, isReused)); 
+    if(block == NULL){
+        throw std::bad_alloc(); 
+    }
+    RecordAllocation(deleter.bucket, isReused); 
+    return std::shared_ptr<unsigned char>(block, deleter); 
+}
+
+void SetBufferPoolLimit(size_t bytes)
+{
+    Pool().SetLimit(bytes); 
+}
+
+size_t GetBufferPoolLimit()
+{
+    return Pool().GetLimit(); 
+}
+
+void ReleasePooledBuffers()
+{
+    Pool().Clear(); 
+}
+
+}
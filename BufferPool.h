@@ -0,0 +1,27 @@
+#ifndef BUFFERPOOL
+#define BUFFERPOOL
+
+#include <cstddef>
+#include <memory>
+
+namespace MedImageParser
+{
+
+/* ------------------------------ Decode buffer pool ---------------------------- */ 
+//Decode buffers are recycled by size instead of being returned to the system, so a
+//worker that loads many volumes of the same shape reuses memory that is already faulted in. 
+//Buffers of 2 MB and more are anonymous mappings advised for transparent huge pages. 
+//The last reference to a buffer hands it back to the pool, which keeps up to its limit
+//of idle bytes and frees the rest. 
+std::shared_ptr<unsigned char> AcquireBuffer(size_t length); 
+
+//idle bytes the pool may keep (1 GB by default), 0 frees every buffer on release: 
+void SetBufferPoolLimit(size_t bytes); 
+size_t GetBufferPoolLimit(); 
+
+//free all idle buffers: 
+void ReleasePooledBuffers(); 
+
+}
+
+#endif
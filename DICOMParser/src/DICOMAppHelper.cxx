@@ -31,6 +31,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <math.h>
 #include <algorithm>
@@ -138,10 +139,17 @@ DICOMAppHelper::DICOMAppHelper()
 {
   this->FileCount = 0;
   this->BitsAllocated = 8;
+  this->BitsStored = 0;
+  this->PixelRepresentation = 0;
   this->ByteSwapData = false;
   this->PixelSpacing[0] = this->PixelSpacing[1] = this->PixelSpacing[2] = 1.0f;
   this->Dimensions[0] = this->Dimensions[1] = 0;
   this->Width = this->Height = 0;
+  this->SliceNumber = -1;
+  this->ImagePositionPatient[0] = this->ImagePositionPatient[1] = this->ImagePositionPatient[2] = 0.0f;
+  this->ImageOrientationPatient[0] = this->ImageOrientationPatient[4] = 1.0f;
+  this->ImageOrientationPatient[1] = this->ImageOrientationPatient[2] = 0.0f;
+  this->ImageOrientationPatient[3] = this->ImageOrientationPatient[5] = 0.0f;
   this->PhotometricInterpretation = NULL;
   this->TransferSyntaxUID = NULL;
   this->CurrentSeriesUID = "";
@@ -181,6 +189,7 @@ DICOMAppHelper::DICOMAppHelper()
   this->TransferSyntaxCB = new DICOMMemberCallback<DICOMAppHelper>;
   this->ToggleSwapBytesCB = new DICOMMemberCallback<DICOMAppHelper>;
   this->BitsAllocatedCB = new DICOMMemberCallback<DICOMAppHelper>;
+  this->BitsStoredCB = new DICOMMemberCallback<DICOMAppHelper>;
   this->PixelSpacingCB = new DICOMMemberCallback<DICOMAppHelper>;
   this->HeightCB = new DICOMMemberCallback<DICOMAppHelper>;
   this->WidthCB = new DICOMMemberCallback<DICOMAppHelper>;
@@ -249,6 +258,7 @@ DICOMAppHelper::~DICOMAppHelper()
   delete this->TransferSyntaxCB;
   delete this->ToggleSwapBytesCB;
   delete this->BitsAllocatedCB;
+  delete this->BitsStoredCB;
   delete this->PixelSpacingCB;
   delete this->HeightCB;
   delete this->WidthCB;
@@ -330,6 +340,9 @@ void DICOMAppHelper::RegisterCallbacks(DICOMParser* parser)
   BitsAllocatedCB->SetCallbackFunction(this, &DICOMAppHelper::BitsAllocatedCallback);
   parser->AddDICOMTagCallback(0x0028, 0x0100, DICOMParser::VR_US, BitsAllocatedCB);
 
+  BitsStoredCB->SetCallbackFunction(this, &DICOMAppHelper::BitsStoredCallback);
+  parser->AddDICOMTagCallback(0x0028, 0x0101, DICOMParser::VR_US, BitsStoredCB);
+
   PixelSpacingCB->SetCallbackFunction(this, &DICOMAppHelper::PixelSpacingCallback);
   parser->AddDICOMTagCallback(0x0028, 0x0030, DICOMParser::VR_FL, PixelSpacingCB);
   parser->AddDICOMTagCallback(0x0018, 0x0050, DICOMParser::VR_FL, PixelSpacingCB);
@@ -824,8 +837,6 @@ void DICOMAppHelper::ArrayCallback(DICOMParser *parser,
       case DICOMParser::VR_DT:
       case DICOMParser::VR_LO:
       case DICOMParser::VR_LT:
-      case DICOMParser::VR_OB: // ordered bytes
-      case DICOMParser::VR_OW: // ordered words
       case DICOMParser::VR_PN:
       case DICOMParser::VR_ST:
       case DICOMParser::VR_TM:
@@ -836,6 +847,10 @@ void DICOMAppHelper::ArrayCallback(DICOMParser *parser,
       case DICOMParser::VR_IS:
         HeaderFile << val;
         break;
+      case DICOMParser::VR_OB: // ordered bytes
+      case DICOMParser::VR_OW: // ordered words, pixel data is not NULL terminated
+        HeaderFile << "(binary)";
+        break;
       case DICOMParser::VR_FL: // float
         fval = static_cast<float> (atof((char*) val));
         HeaderFile << fval;
@@ -873,8 +888,6 @@ void DICOMAppHelper::ArrayCallback(DICOMParser *parser,
   
   HeaderFile << dicom_stream::dec << dicom_stream::endl;
   HeaderFile.fill(prev);
-
-  delete [] val;
 }
     
 void DICOMAppHelper::SliceNumberCallback(DICOMParser *,
@@ -1051,6 +1064,10 @@ void DICOMAppHelper::ImageOrientationPatientCallback(DICOMParser *,
     
     // insert into the map
     this->Implementation->InstanceUIDToSliceOrderingMap.insert(dicom_stl::pair<const dicom_stl::string, DICOMOrderingElements>(this->InstanceUID, ord));
+
+    // cache the value
+    memcpy( this->ImageOrientationPatient, ord.ImageOrientationPatient,
+            6*sizeof(float) );
     }
   else
     {
@@ -1075,6 +1092,10 @@ void DICOMAppHelper::ImageOrientationPatientCallback(DICOMParser *,
       (*it).second.ImageOrientationPatient[4] = 1.0f;
       (*it).second.ImageOrientationPatient[5] = 0.0f;
       }
+
+    // cache the value
+    memcpy( this->ImageOrientationPatient, (*it).second.ImageOrientationPatient,
+            6*sizeof(float) );
     }
 }
 
@@ -1140,6 +1161,26 @@ void DICOMAppHelper::BitsAllocatedCallback(DICOMParser *parser,
 #endif
 }
 
+void DICOMAppHelper::BitsStoredCallback(DICOMParser *parser,
+                                        doublebyte,
+                                        doublebyte,
+                                        DICOMParser::VRTypes,
+                                        unsigned char* val,
+                                        quadbyte len) 
+{
+  if (len == 0)
+    {
+    // no value, all allocated bits are used
+    this->BitsStored = 0;
+    return;
+    }
+  
+  this->BitsStored = parser->GetDICOMFile()->ReturnAsUnsignedShort(val, parser->GetDICOMFile()->GetPlatformIsBigEndian());
+#ifdef DEBUG_DICOM_APP_HELPER
+  dicom_stream::cout << "Bits stored: " << this->BitsStored << dicom_stream::endl;
+#endif
+}
+
 
 void DICOMAppHelper::ToggleSwapBytesCallback(DICOMParser *parser,
                                              doublebyte,
@@ -1302,6 +1343,25 @@ void DICOMAppHelper::PhotometricInterpretationCallback( DICOMParser *,
     }
 }
 
+//
+// Value of pixel i: the low bits of the allocated bits that are
+// stored, sign extended for signed pixel data. The pixel data may be
+// a mapped file at any alignment, so 16 bit pixels are copied out.
+//
+static inline int StoredPixelValue(const unsigned char* data, int i, int ptrIncr, bool isSigned, int unusedBits)
+{
+  unsigned int raw = data[i];
+  if (ptrIncr == 2)
+    {
+    unsigned short word;
+    memcpy(&word, data + 2*i, sizeof(word));
+    raw = word;
+    }
+  int shift = 32 - 8*ptrIncr + unusedBits;
+  raw <<= shift;
+  return isSigned ? (static_cast<int>(raw) >> shift) : static_cast<int>(raw >> shift);
+}
+
 void DICOMAppHelper::PixelDataCallback( DICOMParser *,
                                         doublebyte,
                                         doublebyte,
@@ -1310,7 +1370,9 @@ void DICOMAppHelper::PixelDataCallback( DICOMParser *,
                                         quadbyte len)
 {
   // int numPixels = this->Dimensions[0] * this->Dimensions[1] * this->GetNumberOfComponents();
-  int numPixels = this->Dimensions[0] * this->Dimensions[1] * this->GetSliceNumber();
+  // single frame images carry no number of frames tag
+  int numFrames = (this->GetSliceNumber() > 0) ? this->GetSliceNumber() : 1;
+  int numPixels = this->Dimensions[0] * this->Dimensions[1] * numFrames;
 
   // if length was undefined, i.e. 0xffff, then use numpixels, otherwise...
   if (len != 0xffff)
@@ -1333,9 +1395,12 @@ void DICOMAppHelper::PixelDataCallback( DICOMParser *,
 
   int ptrIncr = int(this->BitsAllocated/8.0);
 
-  unsigned short* ushortInputData = reinterpret_cast<unsigned short*>(data);
-  unsigned char* ucharInputData = data;
-  short* shortInputData = reinterpret_cast<short*> (data);
+  bool isSigned = (this->PixelRepresentation == 1);
+  int unusedBits = 0;
+  if (this->BitsStored > 0 && this->BitsStored < this->BitsAllocated)
+    {
+    unusedBits = this->BitsAllocated - this->BitsStored;
+    }
 
   float* floatOutputData; // = NULL;
   
@@ -1362,7 +1427,7 @@ void DICOMAppHelper::PixelDataCallback( DICOMParser *,
       {
       for (int i = 0; i < numPixels; i++)
         {
-        newFloatPixel = float(this->RescaleSlope * ucharInputData[i] + this->RescaleOffset);
+        newFloatPixel = float(this->RescaleSlope * StoredPixelValue(data, i, 1, isSigned, unusedBits) + this->RescaleOffset);
         floatOutputData[i] = newFloatPixel;
         }
 #ifdef DEBUG_DICOM_APP_HELPER
@@ -1374,7 +1439,7 @@ void DICOMAppHelper::PixelDataCallback( DICOMParser *,
       {
       for (int i = 0; i < numPixels; i++)
         {
-        newFloatPixel = float(this->RescaleSlope * ushortInputData[i] + this->RescaleOffset);
+        newFloatPixel = float(this->RescaleSlope * StoredPixelValue(data, i, 2, isSigned, unusedBits) + this->RescaleOffset);
         floatOutputData[i] = newFloatPixel;
         }
 #ifdef DEBUG_DICOM_APP_HELPER
@@ -1397,17 +1462,29 @@ void DICOMAppHelper::PixelDataCallback( DICOMParser *,
         delete [] (static_cast<char*> (this->ImageData));
         }
       this->ImageData = new char[numPixels];
-  
-      char*  charOutputData =  static_cast<char*>  (this->ImageData);
 
       this->ImageDataType = DICOMParser::VR_OB;
       this->ImageDataLengthInBytes = numPixels * sizeof(char);
-      char newCharPixel;
 
-      for (int i = 0; i < numPixels; i++)
+      //
+      // The rescale is the identity here, the stored values are kept
+      // with the signedness given by the pixel representation.
+      //
+      if (isSigned)
+        {
+        char* charOutputData = static_cast<char*> (this->ImageData);
+        for (int i = 0; i < numPixels; i++)
+          {
+          charOutputData[i] = char(StoredPixelValue(data, i, 1, isSigned, unusedBits));
+          }
+        }
+      else
         {
-        newCharPixel = char(this->RescaleSlope * ucharInputData[i] + this->RescaleOffset);
-        charOutputData[i] = newCharPixel;
+        unsigned char* ucharOutputData = static_cast<unsigned char*> (this->ImageData);
+        for (int i = 0; i < numPixels; i++)
+          {
+          ucharOutputData[i] = static_cast<unsigned char>(StoredPixelValue(data, i, 1, isSigned, unusedBits));
+          }
         }
 #ifdef DEBUG_DICOM_APP_HELPER
       dicom_stream::cout << "Did rescale, offset to char from char." << dicom_stream::endl;
@@ -1421,15 +1498,24 @@ void DICOMAppHelper::PixelDataCallback( DICOMParser *,
         delete [] (static_cast<char*> (this->ImageData));
         }
       this->ImageData = new short[numPixels];
-      short* shortOutputData = static_cast<short*> (this->ImageData);
 
       this->ImageDataType = DICOMParser::VR_OW;
       this->ImageDataLengthInBytes = numPixels * sizeof(short);
-      short newShortPixel;
-      for (int i = 0; i < numPixels; i++)
+      if (isSigned)
+        {
+        short* shortOutputData = static_cast<short*> (this->ImageData);
+        for (int i = 0; i < numPixels; i++)
+          {
+          shortOutputData[i] = short(StoredPixelValue(data, i, 2, isSigned, unusedBits));
+          }
+        }
+      else
         {
-        newShortPixel = short(this->RescaleSlope * shortInputData[i] + this->RescaleOffset);
-        shortOutputData[i] = newShortPixel;
+        unsigned short* ushortOutputData = static_cast<unsigned short*> (this->ImageData);
+        for (int i = 0; i < numPixels; i++)
+          {
+          ushortOutputData[i] = static_cast<unsigned short>(StoredPixelValue(data, i, 2, isSigned, unusedBits));
+          }
         }
 #ifdef DEBUG_DICOM_APP_HELPER
       dicom_stream::cout << "Did rescale, offset to short from short." << dicom_stream::endl;
@@ -2049,10 +2135,13 @@ bool DICOMAppHelper::RescaledImageDataIsFloat()
     {
     return true;
     }
-  else
-    {
-    return false;
-    }
+
+  //
+  // Integer rescales other than the identity can leave the range of
+  // the stored type (unsigned data with a negative offset, or a slope
+  // that overflows it), so they are decoded to float as well.
+  //
+  return (s != 1 || o != 0);
 }
 
 void DICOMAppHelper::GetImageData(void*& data, DICOMParser::VRTypes& dataType, unsigned long& len)
@@ -196,6 +196,13 @@ public:
                                      DICOMParser::VRTypes type,
                                      unsigned char* val,
                                      quadbyte len) ;
+
+  virtual void BitsStoredCallback(DICOMParser *parser,
+                                  doublebyte group,
+                                  doublebyte element,
+                                  DICOMParser::VRTypes type,
+                                  unsigned char* val,
+                                  quadbyte len) ;
   
   virtual void ToggleSwapBytesCallback(DICOMParser *parser,
                                        doublebyte,
@@ -476,6 +483,13 @@ public:
     {
       return this->ImagePositionPatient;
     }
+
+  /** Get the (DICOM) direction cosines of the first row and the first
+   * column of the last image processed by the DICOMParser */
+  float *GetImageOrientationPatient()
+    {
+      return this->ImageOrientationPatient;
+    }
   
   
   /** Get the number of bits allocated per pixel of the last image
@@ -485,6 +499,14 @@ public:
     return this->BitsAllocated;
     }
 
+  /** Get the number of bits stored per pixel of the last image
+   *  processed by the DICOMParser, the low bits of each allocated
+   *  pixel. Zero if the image does not say, i.e. all bits are used. */
+  int GetBitsStored()
+    {
+    return this->BitsStored;
+    }
+
   /** Get the pixel representation of the last image processed by the
    * DICOMParser. A zero is a unsigned quantity.  A one indicates a
    * signed quantity. */
@@ -493,6 +515,20 @@ public:
     return this->PixelRepresentation;
     }
 
+  /** Get the rescale slope of the last image processed by the
+   *  DICOMParser. */
+  float GetRescaleSlope()
+    {
+    return this->RescaleSlope;
+    }
+
+  /** Get the rescale offset (intercept) of the last image processed
+   *  by the DICOMParser. */
+  float GetRescaleOffset()
+    {
+    return this->RescaleOffset;
+    }
+
   /** Get the number of components of the last image processed by the
    *  DICOMParser. */
   unsigned int GetNumberOfComponents()
@@ -539,7 +575,8 @@ public:
   void GetImageData(void* & data, DICOMParser::VRTypes& dataType, unsigned long& len);
 
   /** Determine whether the image data was rescaled (by the
-   *  RescaleSlope tag) to be floating point. */
+   *  RescaleSlope tag) to be floating point. This is the case for
+   *  any rescale other than the identity. */
   bool RescaledImageDataIsFloat();
 
   /** Determine whether the image data was rescaled (by the
@@ -752,6 +789,7 @@ public:
  protected:
   int FileCount;
   int BitsAllocated;
+  int BitsStored;
   bool ByteSwapData;
   float PixelSpacing[3];
   int Width;
@@ -759,6 +797,7 @@ public:
   int SliceNumber; 
   int Dimensions[2];
   float ImagePositionPatient[3];
+  float ImageOrientationPatient[6];
 
   short VolumeSliceSize;
   short VolumeSliceCount;
@@ -814,6 +853,7 @@ public:
   DICOMMemberCallback<DICOMAppHelper>* TransferSyntaxCB;
   DICOMMemberCallback<DICOMAppHelper>* ToggleSwapBytesCB;
   DICOMMemberCallback<DICOMAppHelper>* BitsAllocatedCB;
+  DICOMMemberCallback<DICOMAppHelper>* BitsStoredCB;
   DICOMMemberCallback<DICOMAppHelper>* PixelSpacingCB;
   DICOMMemberCallback<DICOMAppHelper>* HeightCB;
   DICOMMemberCallback<DICOMAppHelper>* WidthCB;
@@ -34,11 +34,11 @@
 namespace DICOMPARSER_NAMESPACE
 {
 DICOMBuffer::DICOMBuffer(unsigned char *buffer, long length)
-  : DICOMSource(),
-    Buffer(buffer),
-    Length(length),
-    Position(0)
+  : DICOMSource()
 {
+  MemoryData = buffer;
+  MemoryLength = length;
+  MemoryPosition = 0;
 }
 
 DICOMBuffer::~DICOMBuffer()
@@ -48,50 +48,49 @@ DICOMBuffer::~DICOMBuffer()
 DICOMBuffer::DICOMBuffer(const DICOMBuffer& in)
   : DICOMSource(in)
 {
-  Buffer = in.Buffer;
-  Length = in.Length;
-  Position = in.Position;
+  MemoryData = in.MemoryData;
+  MemoryLength = in.MemoryLength;
+  MemoryPosition = in.MemoryPosition;
 }
 
 void DICOMBuffer::operator=(const DICOMBuffer& in)
 {
   DICOMSource::operator=(in);
 
-  Buffer = in.Buffer;
-  Length = in.Length;
-  Position = in.Position;
+  MemoryData = in.MemoryData;
+  MemoryLength = in.MemoryLength;
+  MemoryPosition = in.MemoryPosition;
 }
 
 
 long DICOMBuffer::Tell() 
 {
-  return Position;
+  return MemoryPosition;
 }
 
 void DICOMBuffer::SkipToPos(long increment) 
 {
-  Position = increment;
+  MemoryPosition = increment;
 }
 
 long DICOMBuffer::GetSize() 
 {
-  return Length;
+  return MemoryLength;
 }
 
 void DICOMBuffer::Skip(long increment) 
 {
-  Position += increment;
+  MemoryPosition += increment;
 }
 
 void DICOMBuffer::SkipToStart() 
 {
-  Position = 0;
+  MemoryPosition = 0;
 }
 
 void DICOMBuffer::Read(void* ptr, long nbytes) 
 {
-  memcpy(ptr, Buffer+Position, nbytes);
-  Position += nbytes;
+  this->ReadFromMemory(ptr, nbytes);
 }
 
 }
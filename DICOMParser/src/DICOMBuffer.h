@@ -38,7 +38,8 @@
 namespace DICOMPARSER_NAMESPACE
 {
 //
-// DICOM data source that is a memory buffer.
+// DICOM data source that is a memory buffer. The buffer is the
+// memory window of DICOMSource, fixed width reads are inline.
 //
 class DICOM_EXPORT DICOMBuffer : public DICOMSource
 {
@@ -80,10 +81,6 @@ class DICOM_EXPORT DICOMBuffer : public DICOMSource
   DICOMBuffer(const DICOMBuffer&);
   void operator=(const DICOMBuffer&);  
 
-  unsigned char *Buffer;
-  long Length;
-  long Position;
-  
 private:
   DICOMBuffer();
 
@@ -43,6 +43,11 @@ namespace DICOMPARSER_NAMESPACE
 // encountered, the callback is called and passed
 // the group, element, type, data, and data length.
 //
+// The data belongs to the parser and is valid only during the
+// call, callbacks copy what they keep and never free it. Pixel
+// data (7FE0,0010) may point straight into a mapped file and must
+// not be modified, other values are NULL terminated copies.
+//
 
 class DICOM_EXPORT DICOMCallback
 {
@@ -0,0 +1,173 @@
+/*=========================================================================
+
+  Program:   DICOMParser
+  Module:    DICOMMappedFile.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) 2003 Matt Turek
+  All rights reserved.
+  See Copyright.txt for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even 
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4514 )
+#pragma warning ( disable : 4710 )
+#pragma warning ( push, 3 )
+#endif 
+
+#include <stdio.h>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "DICOMConfig.h"
+#include "DICOMMappedFile.h"
+
+namespace DICOMPARSER_NAMESPACE
+{
+DICOMMappedFile::DICOMMappedFile() : DICOMSource(), IsMapped(false)
+{
+}
+
+DICOMMappedFile::~DICOMMappedFile()
+{
+  this->Close();
+}
+
+DICOMMappedFile::DICOMMappedFile(const DICOMMappedFile& in)
+  : DICOMSource(in), IsMapped(false)
+{
+  //
+  // The mapping is owned by one source only, copies are empty.
+  //
+}
+
+void DICOMMappedFile::operator=(const DICOMMappedFile& in)
+{
+  DICOMSource::operator=(in);
+}
+
+bool DICOMMappedFile::Open(const dicom_stl::string& filename)
+{
+  this->Close();
+
+#ifndef _WIN32
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+    return false;
+    }
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+    {
+    close(fd);
+    return false;
+    }
+
+  if (fileStat.st_size > 0)
+    {
+    void* mapped = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped != MAP_FAILED)
+      {
+      MemoryData = static_cast<const unsigned char*>(mapped);
+      MemoryLength = static_cast<long>(fileStat.st_size);
+      IsMapped = true;
+      }
+    }
+  close(fd);
+
+  if (IsMapped || fileStat.st_size == 0)
+    {
+    return true;
+    }
+#endif
+
+  //
+  // Not mappable, read the whole file instead.
+  //
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (!file)
+    {
+    return false;
+    }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (size > 0)
+    {
+    unsigned char* buffer = new unsigned char[size];
+    size = static_cast<long>(fread(buffer, 1, size, file));
+    MemoryData = buffer;
+    MemoryLength = size;
+    }
+  fclose(file);
+  return size >= 0;
+}
+
+void DICOMMappedFile::Close()
+{
+  if (MemoryData)
+    {
+#ifndef _WIN32
+    if (IsMapped)
+      {
+      munmap(const_cast<unsigned char*>(MemoryData), static_cast<size_t>(MemoryLength));
+      }
+    else
+#endif
+      {
+      delete [] MemoryData;
+      }
+    }
+  MemoryData = NULL;
+  MemoryLength = 0;
+  MemoryPosition = 0;
+  IsMapped = false;
+}
+
+long DICOMMappedFile::Tell() 
+{
+  return MemoryPosition;
+}
+
+void DICOMMappedFile::SkipToPos(long increment) 
+{
+  MemoryPosition = increment;
+}
+
+long DICOMMappedFile::GetSize() 
+{
+  return MemoryLength;
+}
+
+void DICOMMappedFile::Skip(long increment) 
+{
+  MemoryPosition += increment;
+}
+
+void DICOMMappedFile::SkipToStart() 
+{
+  MemoryPosition = 0;
+}
+
+void DICOMMappedFile::Read(void* ptr, long nbytes) 
+{
+  this->ReadFromMemory(ptr, nbytes);
+}
+}
+#ifdef _MSC_VER
+#pragma warning ( pop )
+#endif
@@ -0,0 +1,110 @@
+/*=========================================================================
+
+  Program:   DICOMParser
+  Module:    DICOMMappedFile.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) 2003 Matt Turek
+  All rights reserved.
+  See Copyright.txt for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even 
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#ifndef __DICOMMAPPEDFILE_H_
+#define __DICOMMAPPEDFILE_H_
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4514 )
+#pragma warning ( push, 3 )
+#endif 
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "DICOMTypes.h"
+#include "DICOMConfig.h"
+#include "DICOMSource.h"
+
+namespace DICOMPARSER_NAMESPACE
+{
+//
+// DICOM data source that is a file mapped into memory. Where the
+// file cannot be mapped it is read into a buffer in one call.
+// Either way the content is the memory window of DICOMSource, so
+// tags are read without a virtual call or a stream read each.
+//
+class DICOM_EXPORT DICOMMappedFile : public DICOMSource
+{
+ public:
+  DICOMMappedFile();
+  virtual ~DICOMMappedFile();
+  
+  //
+  // Open a file with filename.  Returns a bool
+  // that is true if the file is successfully
+  // mapped or read.
+  //
+  bool Open(const dicom_stl::string& filename);
+  
+  //
+  // Unmap or free the file.
+  //
+  void Close();
+  
+  //
+  // Return the position in the file.
+  //
+  long Tell();
+  
+  // 
+  // Move to a particular position in the file.
+  //
+  void SkipToPos(long);
+  
+  //
+  // Return the size of the file.
+  //
+  long GetSize();
+  
+  //
+  // Skip a number of bytes.
+  // 
+  void Skip(long);
+  
+  //
+  // Skip to the beginning of the file.
+  //
+  void SkipToStart();
+  
+  //
+  // Read data of length len.
+  //
+  void Read(void* data, long len);
+  
+ protected:
+  DICOMMappedFile(const DICOMMappedFile&);
+  void operator=(const DICOMMappedFile&);  
+
+  //
+  // True if MemoryData is a mapping, false if it was allocated.
+  //
+  bool IsMapped;
+
+ private:
+
+};
+}
+#ifdef _MSC_VER
+#pragma warning ( pop )
+#endif
+
+#endif // __DICOMMAPPEDFILE_H_
+
+
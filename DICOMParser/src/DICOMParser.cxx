@@ -37,7 +37,7 @@
 #endif
 
 #include <string.h>
-#include <map>
+#include <algorithm>
 
 #include "DICOMConfig.h"
 #include "DICOMParser.h"
@@ -61,30 +61,226 @@ namespace DICOMPARSER_NAMESPACE
 static const char* DICOM_MAGIC = "DICM";
 static const int   OPTIONAL_SKIP = 128;
 
-class DICOMParserImplementation 
+//
+// Storage of the tag values handed to the callbacks. Values are
+// stacked on top of each other and released back to a mark, so a
+// sequence value stays while its items are parsed. The blocks are
+// kept for the next record and the next file, a parse allocates
+// only when a value does not fit any block yet.
+//
+class DICOMValueArena
 {
 public:
-  DICOMParserImplementation() : Groups(), Elements(), Datatypes(), Map(), TypeMap()
+  struct Mark
+    {
+    size_t Block;
+    size_t Used;
+    };
+
+  DICOMValueArena() : Blocks(), Current(0), Used(0)
+  {
+  }
+
+  ~DICOMValueArena()
   {
+    for (size_t idx = 0; idx < this->Blocks.size(); ++idx)
+      {
+      delete [] this->Blocks[idx].Data;
+      }
+  }
 
-  };
+  unsigned char* Allocate(size_t len)
+  {
+    len = (len + 7) & ~static_cast<size_t>(7);
+    if (this->Current < this->Blocks.size() &&
+        len <= this->Blocks[this->Current].Size - this->Used)
+      {
+      unsigned char* data = this->Blocks[this->Current].Data + this->Used;
+      this->Used += len;
+      return data;
+      }
+
+    // blocks after the current one are free
+    size_t next = (this->Current < this->Blocks.size()) ? this->Current + 1 : 0;
+    while (next < this->Blocks.size() && this->Blocks[next].Size < len)
+      {
+      ++next;
+      }
+    if (next == this->Blocks.size())
+      {
+      size_t size = this->Blocks.empty() ? 4096 : 2 * this->Blocks.back().Size;
+      Block block;
+      block.Size = (size > len) ? size : len;
+      block.Data = new unsigned char[block.Size];
+      this->Blocks.push_back(block);
+      }
+    this->Current = next;
+    this->Used = len;
+    return this->Blocks[next].Data;
+  }
+
+  Mark GetMark() const
+  {
+    Mark mark;
+    mark.Block = this->Current;
+    mark.Used = this->Used;
+    return mark;
+  }
+
+  void Release(const Mark& mark)
+  {
+    this->Current = mark.Block;
+    this->Used = mark.Used;
+  }
+
+private:
+  struct Block
+    {
+    unsigned char* Data;
+    size_t Size;
+    };
+
+  DICOMValueArena(const DICOMValueArena&);
+  void operator=(const DICOMValueArena&);
+
+  dicom_stl::vector<Block> Blocks;
+  size_t Current;
+  size_t Used;
+};
+
+//
+// Registry of the tag callbacks, sorted by (group, element). The
+// keys are searched apart from the values so a lookup touches one
+// small array, and a bitmap over the low byte of the group rejects
+// most tags without callbacks (e.g. odd private groups) before any
+// search.
+//
+class DICOMCallbackTable
+{
+public:
+  DICOMCallbackTable() : Keys(), Values()
+  {
+    memset(this->GroupFilter, 0, sizeof(this->GroupFilter));
+  }
+
+  DICOMMapValue* Find(doublebyte group, doublebyte element)
+  {
+    if (!(this->GroupFilter[(group & 0xFF) >> 5] & (1u << (group & 0x1F))))
+      {
+      return NULL;
+      }
+    unsigned int key = MakeKey(group, element);
+    dicom_stl::vector<unsigned int>::iterator iter =
+      dicom_stl::lower_bound(this->Keys.begin(), this->Keys.end(), key);
+    if (iter == this->Keys.end() || *iter != key)
+      {
+      return NULL;
+      }
+    return &this->Values[iter - this->Keys.begin()];
+  }
+
+  //
+  // Adds the tag unless it is registered already.
+  //
+  void Insert(doublebyte group, doublebyte element, const DICOMMapValue& value)
+  {
+    unsigned int key = MakeKey(group, element);
+    dicom_stl::vector<unsigned int>::iterator iter =
+      dicom_stl::lower_bound(this->Keys.begin(), this->Keys.end(), key);
+    if (iter != this->Keys.end() && *iter == key)
+      {
+      return;
+      }
+    this->Values.insert(this->Values.begin() + (iter - this->Keys.begin()), value);
+    this->Keys.insert(iter, key);
+    this->GroupFilter[(group & 0xFF) >> 5] |= (1u << (group & 0x1F));
+  }
+
+  size_t Size() const
+  {
+    return this->Keys.size();
+  }
+
+  DICOMMapValue& ValueAt(size_t idx)
+  {
+    return this->Values[idx];
+  }
+
+  void Clear()
+  {
+    this->Keys.clear();
+    this->Values.clear();
+    memset(this->GroupFilter, 0, sizeof(this->GroupFilter));
+  }
+
+private:
+  static unsigned int MakeKey(doublebyte group, doublebyte element)
+  {
+    return (static_cast<unsigned int>(group) << 16) | element;
+  }
+
+  dicom_stl::vector<unsigned int> Keys;
+  dicom_stl::vector<DICOMMapValue> Values;
+  unsigned int GroupFilter[8];
+};
+
+//
+// Log of the records parsed by ReadHeader, kept only when the
+// parser is asked to record tags. The datatypes are two character
+// VR codes, so the three columns are stored as doublebytes.
+//
+class DICOMTagLog
+{
+public:
+  DICOMTagLog() : Groups(), Elements(), Datatypes()
+  {
+  }
+
+  void Clear()
+  {
+    this->Groups.clear();
+    this->Elements.clear();
+    this->Datatypes.clear();
+  }
+
+  void Reserve(size_t count)
+  {
+    this->Groups.reserve(count);
+    this->Elements.reserve(count);
+    this->Datatypes.reserve(count);
+  }
+
+  void Add(doublebyte group, doublebyte element, DICOMParser::VRTypes datatype)
+  {
+    this->Groups.push_back(group);
+    this->Elements.push_back(element);
+    this->Datatypes.push_back(static_cast<doublebyte>(datatype));
+  }
 
   dicom_stl::vector<doublebyte> Groups;
   dicom_stl::vector<doublebyte> Elements;
-  dicom_stl::vector<DICOMParser::VRTypes> Datatypes;
+  dicom_stl::vector<doublebyte> Datatypes;
+};
+
+class DICOMParserImplementation 
+{
+public:
+  DICOMParserImplementation() : Tags(), Map(), Values()
+  {
+
+  };
+
+  DICOMTagLog Tags;
   //
-  // Stores a map from pair<group, element> keys to
-  // values of pair<vector<DICOMCallback*>, datatype>
+  // Stores (group, element) keys with values of
+  // pair<datatype, vector<DICOMCallback*>>
   //
-  DICOMParserMap Map;
+  DICOMCallbackTable Map;
 
   //
-  // Stores a map from pair<group, element> keys to
-  // values of datatype.  We use this to store the 
-  // datatypes for implicit keys that we are 
-  // interested in.
+  // Values of the tags with callbacks.
   //
-  DICOMImplicitTypeMap TypeMap;
+  DICOMValueArena Values;
 
 };
 
@@ -92,9 +288,14 @@ DICOMParser::DICOMParser() : ParserOutputFile()
 {
   this->Implementation = new DICOMParserImplementation();
   this->DataFile = NULL;
+  this->UseMappedFile = false;
   this->ToggleByteSwapImageData = false;
+  this->HeaderSource = NULL;
+  this->PixelDataOffset = -1;
+  this->PixelDataLength = 0;
+  this->StopBeforePixelData = false;
+  this->RecordTags = false;
   this->TransferSyntaxCB = new DICOMMemberCallback<DICOMParser>;
-  this->InitTypeMap();
   this->FileName = "";
 }
 
@@ -111,8 +312,19 @@ bool DICOMParser::OpenFile(const dicom_stl::string& filename)
     // Deleting the DataFile closes the file
     delete this->DataFile;
     }
-  this->DataFile = new DICOMFile();
-  bool val = this->DataFile->Open(filename);
+  bool val = false;
+  if (this->UseMappedFile)
+    {
+    DICOMMappedFile* mappedFile = new DICOMMappedFile();
+    val = mappedFile->Open(filename);
+    this->DataFile = mappedFile;
+    }
+  else
+    {
+    DICOMFile* file = new DICOMFile();
+    val = file->Open(filename);
+    this->DataFile = file;
+    }
 
   if (val)
     {
@@ -176,25 +388,41 @@ bool DICOMParser::ReadHeader(DICOMSource &source)
 
   this->ToggleByteSwapImageData = false;
 
+  this->HeaderSource = &source;
+  this->PixelDataOffset = -1;
+  this->PixelDataLength = 0;
+
   doublebyte group = 0;
   doublebyte element = 0;
   DICOMParser::VRTypes datatype = DICOMParser::VR_UNKNOWN;
 
-  this->Implementation->Groups.clear();
-  this->Implementation->Elements.clear();
-  this->Implementation->Datatypes.clear();
+  this->Implementation->Tags.Clear();
+  if (this->RecordTags)
+    {
+    // a typical header has a few hundred records
+    this->Implementation->Tags.Reserve(512);
+    }
 
   long fileSize = source.GetSize();
   do 
     {
     this->ReadNextRecord(source, group, element, datatype);
 
-    this->Implementation->Groups.push_back(group);
-    this->Implementation->Elements.push_back(element);
-    this->Implementation->Datatypes.push_back(datatype);
+    if (this->RecordTags)
+      {
+      this->Implementation->Tags.Add(group, element, datatype);
+      }
+
+    if (this->StopBeforePixelData &&
+        group == 0x7FE0 && element == 0x0010)
+      {
+      break;
+      }
 
     } while ((source.Tell() >= 0) && (source.Tell() < fileSize));
 
+  this->HeaderSource = NULL;
+
   return true;
 }
 
@@ -329,23 +557,64 @@ void DICOMParser::ReadNextRecord(DICOMSource &source, doublebyte& group, doubleb
 
 //   dicom_stream::cout << "representation = " << representation << dicom_stream::dec << ", length = " << length
 //                      << dicom_stream::endl;
+
+  //
+  // Remember where the top level pixel data starts so it can be
+  // accessed in place (e.g. memory mapped) by the caller.
+  //
+  if (group == 0x7FE0 && element == 0x0010 && &source == this->HeaderSource)
+    {
+    if (static_cast<unsigned long>(length) != static_cast<unsigned long>(-1))
+      {
+      this->PixelDataOffset = source.Tell();
+      this->PixelDataLength = length;
+      }
+    else
+      {
+      this->PixelDataOffset = -1;
+      this->PixelDataLength = 0;
+      }
+    }
+
+  if (this->StopBeforePixelData &&
+      group == 0x7FE0 && element == 0x0010 && &source == this->HeaderSource)
+    {
+    return;
+    }
   
-  DICOMParserMap::iterator iter = 
-    Implementation->Map.find(DICOMMapKey(group,element));
+  DICOMMapValue* mapValue = Implementation->Map.Find(group, element);
 
   VRTypes callbackType;
 
-  if (iter != Implementation->Map.end())
+  if (mapValue)
     {
+    callbackType = VRTypes(mapValue->first);
+  
+    if (callbackType != mytype &&
+        mytype != VR_UNKNOWN)
+      {
+      //
+      // mytype is not VR_UNKNOWN if the file is in Explicit format.
+      //
+      callbackType = mytype;
+      }
+
+    bool isPixelData = (group == 0x7FE0 && element == 0x0010);
+    bool doSwap = (this->ToggleByteSwapImageData ^ source.GetPlatformIsBigEndian()) && callbackType == VR_OW;
+
     //
-    // Only read the data if there's a registered callback.
+    // Only read the data if there's a registered callback. Pixel
+    // data that needs no swapping is passed in place, everything
+    // else is copied to the value arena and released below.
     //
+    DICOMValueArena::Mark valueMark = this->Implementation->Values.GetMark();
+    bool inPlace = isPixelData && !doSwap;
     unsigned char* tempdata = 0;
 
     if (static_cast<unsigned long>(length) != static_cast<unsigned long>(-1))
       {
       // length was specified
-      tempdata = (unsigned char*) source.ReadAsciiCharArray(length);
+      tempdata = this->ReadValue(source, length, inPlace);
       }
     else
       {
@@ -366,7 +635,7 @@ void DICOMParser::ReadNextRecord(DICOMSource &source, doublebyte& group, doubleb
         // read the buffer
         if (itemLength != 0)
           {
-          tempdata = (unsigned char *) source.ReadAsciiCharArray(itemLength);
+          tempdata = this->ReadValue(source, itemLength, inPlace);
           // should accumulate the block of memory in case the image
           // is broken into several items
           }
@@ -382,31 +651,12 @@ void DICOMParser::ReadNextRecord(DICOMSource &source, doublebyte& group, doubleb
         source.ReadQuadByte();
         }
       }
-    
-    
-    DICOMMapKey ge = (*iter).first;
-    callbackType = VRTypes(((*iter).second.first));
-  
-    if (callbackType != mytype &&
-        mytype != VR_UNKNOWN)
-      {
-      //
-      // mytype is not VR_UNKNOWN if the file is in Explicit format.
-      //
-      callbackType = mytype;
-      }
- 
+
 #ifdef DEBUG_DICOM
     this->DumpTag(this->ParserOutputFile, group, element, callbackType, tempdata, length);
 #endif
 
-    dicom_stl::pair<const DICOMMapKey,DICOMMapValue> p = *iter;
-    DICOMMapValue mv = p.second;
-
-    bool doSwap = (this->ToggleByteSwapImageData ^ source.GetPlatformIsBigEndian()) && callbackType == VR_OW;
-
-    if (group == 0x7FE0 &&
-        element == 0x0010 )
+    if (isPixelData)
       {
       if (doSwap)
         {
@@ -439,14 +689,14 @@ void DICOMParser::ReadNextRecord(DICOMSource &source, doublebyte& group, doubleb
         }
       }
 
-    dicom_stl::vector<DICOMCallback*> * cbVector = mv.second;
+    dicom_stl::vector<DICOMCallback*> * cbVector = mapValue->second;
     for (dicom_stl::vector<DICOMCallback*>::iterator cbiter = cbVector->begin();
          cbiter != cbVector->end();
          cbiter++)
       {
       (*cbiter)->Execute(this,      // parser
-                       ge.first,  // group
-                       ge.second,  // element
+                       group,  // group
+                       element,  // element
                        callbackType,  // type
                        tempdata, // data
                        length);  // length
@@ -458,10 +708,7 @@ void DICOMParser::ReadNextRecord(DICOMSource &source, doublebyte& group, doubleb
       this->ParseSequence(tempdata, length);
       }
 
-    if (tempdata)
-      {
-      delete [] tempdata;
-      }
+    this->Implementation->Values.Release(valueMark);
     }
   else
     {
@@ -479,6 +726,28 @@ void DICOMParser::ReadNextRecord(DICOMSource &source, doublebyte& group, doubleb
     }
 }
 
+unsigned char* DICOMParser::ReadValue(DICOMSource &source, quadbyte length, bool inPlace)
+{
+  if (length <= 0)
+    {
+    return NULL;
+    }
+
+  if (inPlace)
+    {
+    const unsigned char* value = source.ReadInPlace(length);
+    if (value)
+      {
+      return const_cast<unsigned char*>(value);
+      }
+    }
+
+  unsigned char* value = this->Implementation->Values.Allocate(static_cast<size_t>(length) + 1);
+  source.Read(value, length);
+  value[length] = 0; // NULL terminate.
+  return value;
+}
+
 void DICOMParser::ParseSequence(unsigned char *buffer, quadbyte len)
 {
   // dicom_stream::cout << dicom_stream::dec << "ParseSequence(), len = " << len << dicom_stream::endl;
@@ -512,12 +781,16 @@ void DICOMParser::ParseSequence(unsigned char *buffer, quadbyte len)
       }
     else
       {
-      // Get the block of data for this item
-      char *itemValue;
-      itemValue = DataBuffer.ReadAsciiCharArray(itemLength);
+      // The data block of this item, in place in the sequence
+      const unsigned char *itemValue = DataBuffer.ReadInPlace(itemLength);
+      if (!itemValue)
+        {
+        dicom_stream::cerr << "DICOMParser:: sequence item longer than the sequence.  Skipping rest of sequence." << dicom_stream::endl;
+        return;
+        }
 
       // Wrap this data block into a DICOMBuffer
-      DICOMBuffer tBuffer((unsigned char *)itemValue, itemLength);
+      DICOMBuffer tBuffer(const_cast<unsigned char *>(itemValue), itemLength);
 
       // Parse the DICOMBuffer
       while (tBuffer.Tell() < itemLength)
@@ -528,12 +801,11 @@ void DICOMParser::ParseSequence(unsigned char *buffer, quadbyte len)
         
         this->ReadNextRecord(tBuffer, group, element, datatype);
 
-        this->Implementation->Groups.push_back(group);
-        this->Implementation->Elements.push_back(element);
-        this->Implementation->Datatypes.push_back(datatype);
+        if (this->RecordTags)
+          {
+          this->Implementation->Tags.Add(group, element, datatype);
+          }
         }
-      
-      delete [] itemValue;
       }
     } 
 
@@ -541,65 +813,76 @@ void DICOMParser::ParseSequence(unsigned char *buffer, quadbyte len)
   
 }
 
-void DICOMParser::InitTypeMap()
+DICOMParser::VRTypes DICOMParser::GetImplicitType(doublebyte group, doublebyte element)
 {
-  DICOMRecord dicom_tags[] = {{0x0002, 0x0002, DICOMParser::VR_UI}, // Media storage SOP class uid
-                              {0x0002, 0x0003, DICOMParser::VR_UI}, // Media storage SOP inst uid
-                              {0x0002, 0x0010, DICOMParser::VR_UI}, // Transfer syntax uid
-                              {0x0002, 0x0012, DICOMParser::VR_UI}, // Implementation class uid
-                              {0x0008, 0x0018, DICOMParser::VR_UI}, // Image UID
-                              {0x0008, 0x0020, DICOMParser::VR_DA}, // Series date
-                              {0x0008, 0x0030, DICOMParser::VR_TM}, // Series time
-                              {0x0008, 0x0060, DICOMParser::VR_SH}, // Modality
-                              {0x0008, 0x0070, DICOMParser::VR_SH}, // Manufacturer
-                              {0x0008, 0x0080, DICOMParser::VR_LO}, // Institution
-                              {0x0008, 0x1060, DICOMParser::VR_SH}, // Physician
-                              {0x0008, 0x1090, DICOMParser::VR_LO}, // Model
-                              {0x0010, 0x0010, DICOMParser::VR_PN}, // Patient name                    
-                              {0x0010, 0x0020, DICOMParser::VR_LO}, // Patient ID
-                              {0x0010, 0x0040, DICOMParser::VR_CS}, // Patient sex                    
-                              {0x0010, 0x1010, DICOMParser::VR_AS}, // Patient age
-                              {0x0018, 0x0050, DICOMParser::VR_FL}, // slice thickness
-                              {0x0018, 0x0060, DICOMParser::VR_FL}, // kV
-                              {0x0018, 0x0088, DICOMParser::VR_FL}, // slice spacing
-                              {0x0018, 0x1100, DICOMParser::VR_SH}, // Recon diameter
-                              {0x0018, 0x1151, DICOMParser::VR_FL}, // mA
-                              {0x0018, 0x1210, DICOMParser::VR_SH}, // Recon kernel
-                              {0x0020, 0x000d, DICOMParser::VR_UI}, // Study UID
-                              {0x0020, 0x000e, DICOMParser::VR_UI}, // Series UID
-                              {0x0020, 0x0013, DICOMParser::VR_IS}, // Image number
-                              {0x0020, 0x0032, DICOMParser::VR_SH}, // Patient position
-                              {0x0020, 0x0037, DICOMParser::VR_SH}, // Patient position cosines
-                              {0x0028, 0x0010, DICOMParser::VR_US}, // Num rows
-                              {0x0028, 0x0011, DICOMParser::VR_US}, // Num cols
-                              {0x0028, 0x0030, DICOMParser::VR_FL}, // pixel spacing
-                              {0x0028, 0x0100, DICOMParser::VR_US}, // Bits allocated
-                              {0x0028, 0x0120, DICOMParser::VR_UL}, // pixel padding
-                              {0x0028, 0x1052, DICOMParser::VR_FL}, // pixel offset
-                              {0x7FE0, 0x0010, DICOMParser::VR_OW}   // pixel data
+  //
+  // Datatypes of the implicit VR tags we are interested in,
+  // sorted by group, element for the binary search below.
+  //
+  static const DICOMRecord ImplicitTypes[] = {
+    {0x0002, 0x0002, VR_UI}, // Media storage SOP class uid
+    {0x0002, 0x0003, VR_UI}, // Media storage SOP inst uid
+    {0x0002, 0x0010, VR_UI}, // Transfer syntax uid
+    {0x0002, 0x0012, VR_UI}, // Implementation class uid
+    {0x0008, 0x0018, VR_UI}, // Image UID
+    {0x0008, 0x0020, VR_DA}, // Series date
+    {0x0008, 0x0030, VR_TM}, // Series time
+    {0x0008, 0x0060, VR_SH}, // Modality
+    {0x0008, 0x0070, VR_SH}, // Manufacturer
+    {0x0008, 0x0080, VR_LO}, // Institution
+    {0x0008, 0x1060, VR_SH}, // Physician
+    {0x0008, 0x1090, VR_LO}, // Model
+    {0x0010, 0x0010, VR_PN}, // Patient name
+    {0x0010, 0x0020, VR_LO}, // Patient ID
+    {0x0010, 0x0040, VR_CS}, // Patient sex
+    {0x0010, 0x1010, VR_AS}, // Patient age
+    {0x0018, 0x0050, VR_FL}, // slice thickness
+    {0x0018, 0x0060, VR_FL}, // kV
+    {0x0018, 0x0088, VR_FL}, // slice spacing
+    {0x0018, 0x1100, VR_SH}, // Recon diameter
+    {0x0018, 0x1151, VR_FL}, // mA
+    {0x0018, 0x1210, VR_SH}, // Recon kernel
+    {0x0020, 0x000d, VR_UI}, // Study UID
+    {0x0020, 0x000e, VR_UI}, // Series UID
+    {0x0020, 0x0013, VR_IS}, // Image number
+    {0x0020, 0x0032, VR_SH}, // Patient position
+    {0x0020, 0x0037, VR_SH}, // Patient position cosines
+    {0x0028, 0x0010, VR_US}, // Num rows
+    {0x0028, 0x0011, VR_US}, // Num cols
+    {0x0028, 0x0030, VR_FL}, // pixel spacing
+    {0x0028, 0x0100, VR_US}, // Bits allocated
+    {0x0028, 0x0120, VR_UL}, // pixel padding
+    {0x0028, 0x1052, VR_FL}, // pixel offset
+    {0x7FE0, 0x0010, VR_OW}  // pixel data
   };
 
-
-  int num_tags = sizeof(dicom_tags)/sizeof(DICOMRecord);
-
-  doublebyte group;
-  doublebyte element;
-  VRTypes datatype;
-
-  for (int i = 0; i < num_tags; i++)
+  int low = 0;
+  int high = static_cast<int>(sizeof(ImplicitTypes)/sizeof(DICOMRecord)) - 1;
+  unsigned int key = (static_cast<unsigned int>(group) << 16) | element;
+  while (low <= high)
     {
-    group = dicom_tags[i].group;
-    element = dicom_tags[i].element;
-    datatype = (VRTypes) dicom_tags[i].datatype;
-    Implementation->TypeMap.insert(dicom_stl::pair<const DICOMMapKey, DICOMTypeValue>(DICOMMapKey(group, element), datatype));
+    int mid = (low + high) / 2;
+    unsigned int midKey = (static_cast<unsigned int>(ImplicitTypes[mid].group) << 16) | ImplicitTypes[mid].element;
+    if (midKey == key)
+      {
+      return ImplicitTypes[mid].datatype;
+      }
+    if (midKey < key)
+      {
+      low = mid + 1;
+      }
+    else
+      {
+      high = mid - 1;
+      }
     }
-
+  return VR_UNKNOWN;
 }
 
 
 void DICOMParser::SetDICOMTagCallbacks(doublebyte group, doublebyte element, VRTypes datatype, dicom_stl::vector<DICOMCallback*>* cbVector)
 {
-  Implementation->Map.insert(dicom_stl::pair<const DICOMMapKey, DICOMMapValue>(DICOMMapKey(group, element), DICOMMapValue((int)datatype, cbVector)));
+  Implementation->Map.Insert(group, element, DICOMMapValue((int)datatype, cbVector));
 }
 
 
@@ -688,14 +971,14 @@ void DICOMParser::ModalityTag(doublebyte, doublebyte, VRTypes, unsigned char* te
 
 void DICOMParser::AddDICOMTagCallbacks(doublebyte group, doublebyte element, VRTypes datatype, dicom_stl::vector<DICOMCallback*>* cbVector)
 {
-  DICOMParserMap::iterator miter = Implementation->Map.find(DICOMMapKey(group,element));
-  if (miter != Implementation->Map.end())
+  DICOMMapValue* mapValue = Implementation->Map.Find(group, element);
+  if (mapValue)
     {
     for (dicom_stl::vector<DICOMCallback*>::iterator iter = cbVector->begin();
          iter != cbVector->end();
          iter++)
       {
-      dicom_stl::vector<DICOMCallback*>* callbacks = (*miter).second.second;
+      dicom_stl::vector<DICOMCallback*>* callbacks = mapValue->second;
       callbacks->push_back(*iter);
       }
     }
@@ -707,10 +990,10 @@ void DICOMParser::AddDICOMTagCallbacks(doublebyte group, doublebyte element, VRT
 
 void DICOMParser::AddDICOMTagCallback(doublebyte group, doublebyte element, VRTypes datatype, DICOMCallback* cb)
 {
-  DICOMParserMap::iterator miter = Implementation->Map.find(DICOMMapKey(group,element));
-  if (miter != Implementation->Map.end())
+  DICOMMapValue* mapValue = Implementation->Map.Find(group, element);
+  if (mapValue)
     {
-    dicom_stl::vector<DICOMCallback*>* callbacks = (*miter).second.second;
+    dicom_stl::vector<DICOMCallback*>* callbacks = mapValue->second;
     callbacks->push_back(cb);
     }
   else
@@ -723,12 +1006,9 @@ void DICOMParser::AddDICOMTagCallback(doublebyte group, doublebyte element, VRTy
 
 void DICOMParser::AddDICOMTagCallbackToAllTags(DICOMCallback* cb)
 {
-  DICOMParserMap::iterator miter;
-  for (miter = Implementation->Map.begin();
-       miter != Implementation->Map.end();
-       miter++)
+  for (size_t idx = 0; idx < Implementation->Map.Size(); idx++)
   {
-  dicom_stl::vector<DICOMCallback*>* callbacks = (*miter).second.second;
+  dicom_stl::vector<DICOMCallback*>* callbacks = Implementation->Map.ValueAt(idx).second;
   callbacks->push_back(cb);
   }
 }
@@ -757,9 +1037,7 @@ bool DICOMParser::ParseImplicitRecord(doublebyte group, doublebyte element,
                                       quadbyte& length,
                                       VRTypes& represent)
 {
-  DICOMImplicitTypeMap::iterator iter = 
-    Implementation->TypeMap.find(DICOMMapKey(group,element));
-  represent = VRTypes((*iter).second);
+  represent = this->GetImplicitType(group, element);
   //
   // length?
   //
@@ -818,40 +1096,28 @@ void DICOMParser::GetGroupsElementsDatatypes(dicom_stl::vector<doublebyte>& grou
                                              dicom_stl::vector<doublebyte>& elements,
                                              dicom_stl::vector<DICOMParser::VRTypes>& datatypes)
 {
-  groups.clear();
-  elements.clear();
-  datatypes.clear();
+  const DICOMTagLog& tags = this->Implementation->Tags;
 
-  dicom_stl::vector<doublebyte>::iterator giter; // = this->Groups.begin();
-  dicom_stl::vector<doublebyte>::iterator eiter; // = this->Elements.begin();
-  dicom_stl::vector<DICOMParser::VRTypes>::iterator diter; // = this->Datatypes.begin();
-  
-  for (giter = this->Implementation->Groups.begin(), eiter = this->Implementation->Elements.begin(), diter = this->Implementation->Datatypes.begin();
-       giter != this->Implementation->Groups.end(), eiter != this->Implementation->Elements.end(), diter != this->Implementation->Datatypes.end();
-       giter++, eiter++, diter++)
+  groups.assign(tags.Groups.begin(), tags.Groups.end());
+  elements.assign(tags.Elements.begin(), tags.Elements.end());
+  datatypes.clear();
+  datatypes.reserve(tags.Datatypes.size());
+  for (size_t idx = 0; idx < tags.Datatypes.size(); ++idx)
     {
-    groups.push_back(*giter);
-    elements.push_back(*eiter);
-    datatypes.push_back(*diter);
+    datatypes.push_back(static_cast<DICOMParser::VRTypes>(tags.Datatypes[idx]));
     }
 }
 
 void DICOMParser::ClearAllDICOMTagCallbacks()
 {
-  DICOMParserMap::iterator mapIter;
-  
-  for (mapIter = this->Implementation->Map.begin();
-       mapIter != this->Implementation->Map.end();
-       mapIter++)
+  for (size_t idx = 0; idx < this->Implementation->Map.Size(); idx++)
        {
-       dicom_stl::pair<const DICOMMapKey, DICOMMapValue> mapPair = *mapIter;
-       DICOMMapValue mapVal = mapPair.second;
-       dicom_stl::vector<DICOMCallback*>* cbVector = mapVal.second;
+       dicom_stl::vector<DICOMCallback*>* cbVector = this->Implementation->Map.ValueAt(idx).second;
        
        delete cbVector;
        }
 
-  this->Implementation->Map.clear();
+  this->Implementation->Map.Clear();
 }
 
 DICOMParser::DICOMParser(const DICOMParser&)
@@ -37,6 +37,7 @@
 
 #include "DICOMConfig.h"
 #include "DICOMFile.h"
+#include "DICOMMappedFile.h"
 #include "DICOMTypes.h"
 #include "DICOMParserMap.h"
 
@@ -157,7 +158,10 @@ class DICOM_EXPORT DICOMParser
   void AddDICOMTagCallback (doublebyte group, doublebyte element, VRTypes datatype, DICOMCallback* cb);
   void AddDICOMTagCallbackToAllTags(DICOMCallback* cb);
 
-  DICOMFile* GetDICOMFile()
+  //
+  // The source opened by OpenFile, a DICOMFile or a DICOMMappedFile.
+  //
+  DICOMSource* GetDICOMFile()
     {
     return this->DataFile;
     }
@@ -172,10 +176,82 @@ class DICOM_EXPORT DICOMParser
                               unsigned char* val,
                               quadbyte) ;
 
+  //
+  // Records parsed by the last ReadHeader call, in file order. The
+  // lists are empty unless RecordTags was set before parsing.
+  //
   void GetGroupsElementsDatatypes(dicom_stl::vector<doublebyte>& groups,
                                   dicom_stl::vector<doublebyte>& elements,
                                   dicom_stl::vector<VRTypes>& datatypes);
 
+  //
+  // Position of the pixel data element (7FE0,0010) in the source
+  // last parsed by ReadHeader. The offset is -1 if no pixel data
+  // was found or its length is undefined (encapsulated data).
+  //
+  long GetPixelDataOffset()
+    {
+    return this->PixelDataOffset;
+    }
+
+  quadbyte GetPixelDataLength()
+    {
+    return this->PixelDataLength;
+    }
+
+  //
+  // True if the transfer syntax stores the image data in the
+  // opposite byte order of the file header (explicit big endian).
+  //
+  bool GetToggleByteSwapImageData()
+    {
+    return this->ToggleByteSwapImageData;
+    }
+
+  //
+  // When set, ReadHeader returns as soon as it reaches the top
+  // level pixel data element, without reading or skipping it.
+  // Everything before (7FE0,0010) is still dispatched to callbacks.
+  //
+  void SetStopBeforePixelData(bool stop)
+    {
+    this->StopBeforePixelData = stop;
+    }
+
+  bool GetStopBeforePixelData()
+    {
+    return this->StopBeforePixelData;
+    }
+
+  //
+  // When set, ReadHeader logs the group, element and datatype of
+  // every record for GetGroupsElementsDatatypes. Off by default.
+  //
+  void SetRecordTags(bool record)
+    {
+    this->RecordTags = record;
+    }
+
+  bool GetRecordTags()
+    {
+    return this->RecordTags;
+    }
+
+  //
+  // When set, OpenFile maps the file (DICOMMappedFile) instead of
+  // opening a stream on it (DICOMFile). Takes effect at the next
+  // OpenFile call.
+  //
+  void SetUseMappedFile(bool mapped)
+    {
+    this->UseMappedFile = mapped;
+    }
+
+  bool GetUseMappedFile()
+    {
+    return this->UseMappedFile;
+    }
+
  protected:
 
   bool ParseExplicitRecord(doublebyte group, doublebyte element, 
@@ -209,15 +285,23 @@ class DICOM_EXPORT DICOMParser
   //
   void ReadNextRecord(DICOMSource &source, doublebyte& group, doublebyte& element, DICOMParser::VRTypes& mytype);
 
+  //
+  // Value of a tag with callbacks. Copied to the value arena and
+  // NULL terminated, or with inPlace a pointer into a memory source.
+  // NULL for an empty value.
+  //
+  unsigned char* ReadValue(DICOMSource &source, quadbyte length, bool inPlace);
+
   //
   // Parse a sequence from a memory block
   //
   void ParseSequence(unsigned char *buffer, quadbyte len);
   
   //
-  // Sets up the type map.
+  // Datatype of an implicit VR tag, VR_UNKNOWN for tags that are
+  // not in the type table.
   //
-  void InitTypeMap();
+  static VRTypes GetImplicitType(doublebyte group, doublebyte element);
   
   //
   // Flags for byte swaping header values and 
@@ -246,13 +330,24 @@ class DICOM_EXPORT DICOMParser
   dicom_stream::ofstream ParserOutputFile;
 
   //
-  // Pointer to the DICOMFile we're parsing.
+  // Pointer to the file source we're parsing.
   //
-  DICOMFile* DataFile;
+  DICOMSource* DataFile;
+  bool UseMappedFile;
   dicom_stl::string FileName;
   
   bool ToggleByteSwapImageData;
 
+  //
+  // Top level source of the current ReadHeader call and the
+  // pixel data location found in it.
+  //
+  DICOMSource* HeaderSource;
+  long PixelDataOffset;
+  quadbyte PixelDataLength;
+  bool StopBeforePixelData;
+  bool RecordTags;
+
   //dicom_stl::vector<doublebyte> Groups;
   //dicom_stl::vector<doublebyte> Elements;
   //dicom_stl::vector<VRTypes> Datatypes;
@@ -34,6 +34,9 @@
 namespace DICOMPARSER_NAMESPACE
 {
 DICOMSource::DICOMSource() 
+  : MemoryData(NULL),
+    MemoryLength(0),
+    MemoryPosition(0)
 {
   /* Are we little or big endian?  From Harbison&Steele.  */
   union
@@ -58,6 +61,9 @@ DICOMSource::~DICOMSource()
 }
 
 DICOMSource::DICOMSource(const DICOMSource& in)
+  : MemoryData(NULL),
+    MemoryLength(0),
+    MemoryPosition(0)
 {
   if (strcmp(in.PlatformEndian, "LittleEndian") == 0)
     {
@@ -81,40 +87,26 @@ void DICOMSource::operator=(const DICOMSource& in)
     }
 }
 
-doublebyte DICOMSource::ReadDoubleByte() 
+void DICOMSource::ReadFromMemory(void* ptr, long nbytes)
 {
-  doublebyte sh = 0;
-  int sz = sizeof(doublebyte);
-  this->Read((char*)&(sh),sz); 
-  if (PlatformIsBigEndian) 
+  long available = 0;
+  if (this->MemoryPosition >= 0 && this->MemoryPosition < this->MemoryLength)
     {
-    sh = swapShort(sh);
+    available = this->MemoryLength - this->MemoryPosition;
     }
-  return(sh);
-}
-
-doublebyte DICOMSource::ReadDoubleByteAsLittleEndian() 
-{
-  doublebyte sh = 0;
-  int sz = sizeof(doublebyte);
-  this->Read((char*)&(sh),sz); 
-  if (PlatformIsBigEndian)
+  if (available > nbytes)
     {
-    sh = swapShort(sh);
+    available = nbytes;
     }
-  return(sh);
-}
-
-quadbyte DICOMSource::ReadQuadByte() 
-{
-  quadbyte sh;
-  int sz = sizeof(quadbyte);
-  this->Read((char*)&(sh),sz);
-  if (PlatformIsBigEndian) 
+  if (available > 0)
+    {
+    memcpy(ptr, this->MemoryData + this->MemoryPosition, available);
+    }
+  if (nbytes > available)
     {
-    sh = swapLong(sh);
+    memset(static_cast<char*>(ptr) + available, 0, nbytes - available);
     }
-  return(sh);
+  this->MemoryPosition += nbytes;
 }
 
 quadbyte DICOMSource::ReadNBytes(int len) 
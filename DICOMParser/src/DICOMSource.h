@@ -75,16 +75,62 @@ class DICOM_EXPORT DICOMSource
   //
   virtual void Read(void* data, long len)=0;
   
+  //
+  // Pointer to the next len bytes of the memory window, the position
+  // moves past them. NULL, without moving, for stream sources or if
+  // fewer than len bytes are left. The bytes stay valid as long as
+  // the source and must not be modified.
+  //
+  const unsigned char* ReadInPlace(long len)
+    {
+    if (this->MemoryData && this->MemoryPosition >= 0 && len >= 0 &&
+        len <= this->MemoryLength - this->MemoryPosition)
+      {
+      const unsigned char* data = this->MemoryData + this->MemoryPosition;
+      this->MemoryPosition += len;
+      return data;
+      }
+    return NULL;
+    }
+
   //
   // Read a double byte of data.
   //
-  virtual doublebyte ReadDoubleByte();
-  virtual doublebyte ReadDoubleByteAsLittleEndian();
+  doublebyte ReadDoubleByte()
+    {
+    doublebyte sh = 0;
+    this->ReadFixed(&sh, sizeof(doublebyte));
+    if (PlatformIsBigEndian)
+      {
+      sh = swapShort(sh);
+      }
+    return sh;
+    }
+
+  doublebyte ReadDoubleByteAsLittleEndian()
+    {
+    doublebyte sh = 0;
+    this->ReadFixed(&sh, sizeof(doublebyte));
+    if (PlatformIsBigEndian)
+      {
+      sh = swapShort(sh);
+      }
+    return sh;
+    }
 
   //
   // Read a quadbyte of data.
   //
-  virtual quadbyte   ReadQuadByte();
+  quadbyte   ReadQuadByte()
+    {
+    quadbyte sh = 0;
+    this->ReadFixed(&sh, sizeof(quadbyte));
+    if (PlatformIsBigEndian)
+      {
+      sh = swapLong(sh);
+      }
+    return sh;
+    }
   
   //
   // Read nbytes of data up to 4 bytes.
@@ -213,6 +259,37 @@ class DICOM_EXPORT DICOMSource
   DICOMSource(const DICOMSource&);
   void operator=(const DICOMSource&);  
 
+  //
+  // Fixed width read. Sources that hold their content in memory
+  // are read inline from the memory window, others through Read().
+  //
+  void ReadFixed(void* data, long len)
+    {
+    const unsigned char* inPlace = this->ReadInPlace(len);
+    if (inPlace)
+      {
+      memcpy(data, inPlace, len);
+      }
+    else
+      {
+      this->Read(data, len);
+      }
+    }
+
+  //
+  // Read of a memory source. Bytes past the end of the window
+  // are zeroed, the position still moves by len.
+  //
+  void ReadFromMemory(void* data, long len);
+
+  //
+  // Memory window of sources that hold their content in memory
+  // (DICOMBuffer, DICOMMappedFile). NULL for stream sources.
+  //
+  const unsigned char* MemoryData;
+  long MemoryLength;
+  long MemoryPosition;
+
   //
   // Flag for swaping bytes.
   //
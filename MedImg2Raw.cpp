@@ -15,7 +15,7 @@ int main(int argc, char *argv[]){
     // float spacingX, spacingY, spacingZ; 
     // float originX, originY, originZ; 
 
-    // std::vector<float> data; 
+    // MedImageParser::FloatBuffer data; 
 
     // MedImageParser::read_nii("/home/wenhai/img_registration_ws/MNI_BITE/group2/01/01a_us_tal.nii", dimX, dimY, dimZ, spacingX, spacingY, spacingZ, originX, originY, originZ, data); 
 
@@ -0,0 +1,589 @@
+/*
+    MedImgBench.cpp
+    Purpose: Benchmark of the format readers on synthetic volumes.
+
+    Writes NIfTI (.nii, .nii.gz), NRRD (raw, gzip, bzip2, ascii) and DICOM files of several voxel types
+    and sizes into a scratch directory, then times for each file:
+    header parse (ReadHeader), decode (ReadNative: read, inflate, parse), the inflate part of the decode,
+    float conversion and the total
+    of Read() on a fresh object, plus output MB/s and the peak RSS of the process reading it.
+    Every case runs in its own child process, so the peak RSS belongs to that reader alone; a case whose
+    child cannot be started or does not report back is shown as failed.
+    The files are read right after being written, the numbers are for a warm page cache.
+
+    Usage: MedImgBench [--sizes 64,192] [--repeats 5] [--threads 0] [--dir PATH] [--csv] [--keep]
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+
+#include "MedImgParser.h"
+#include "NrrdIO.h"
+#include "zlib/zlib.h"
+
+/* ------------------------------ Synthetic volumes ---------------------------- */ 
+enum BenchType{
+    BENCH_UINT8 = 0, 
+    BENCH_INT16, 
+    BENCH_UINT16, 
+    BENCH_INT32, 
+    BENCH_FLOAT32, 
+    BENCH_FLOAT64
+}; 
+
+struct BenchCase{
+    std::string format; 
+    std::string encoding; 
+    BenchType type; 
+    int dim[3]; 
+    std::string path; 
+}; 
+
+static const char* BenchTypeName(BenchType type)
+{
+    switch (type)
+    {
+    case BENCH_UINT8: return "uint8"; 
+    case BENCH_INT16: return "int16"; 
+    case BENCH_UINT16: return "uint16"; 
+    case BENCH_INT32: return "int32"; 
+    case BENCH_FLOAT32: return "float32"; 
+    case BENCH_FLOAT64: return "float64"; 
+    default: return "unknown"; 
+    }
+}
+
+static size_t BenchTypeSize(BenchType type)
+{
+    switch (type)
+    {
+    case BENCH_UINT8: return 1; 
+    case BENCH_INT16:
+    case BENCH_UINT16: return 2; 
+    case BENCH_INT32:
+    case BENCH_FLOAT32: return 4; 
+    case BENCH_FLOAT64: return 8; 
+    default: return 0; 
+    }
+}
+
+//smooth structure plus a little fixed-seed noise, so gzip neither explodes nor collapses: 
+static void SynthesizeVoxels(BenchType type, const int dim[3], std::vector<unsigned char>& bytes)
+{
+    size_t voxelBytes = BenchTypeSize(type); 
+    size_t numVoxels = static_cast<size_t>(dim[0]) * dim[1] * dim[2]; 
+    bytes.resize(numVoxels * voxelBytes); 
+
+    uint32_t seed = 12345; 
+    size_t idx = 0; 
+    for(int z = 0; z < dim[2]; ++z){
+        for(int y = 0; y < dim[1]; ++y){
+            for(int x = 0; x < dim[0]; ++x, ++idx){
+                seed = seed * 1664525u + 1013904223u; 
+                double value = 100.0 * std::sin(x * 0.05) * std::cos(y * 0.07) + z * 0.5 + static_cast<double>(seed >> 28); 
+                unsigned char *dst = bytes.data() + idx * voxelBytes; 
+                switch (type)
+                {
+                case BENCH_UINT8: { uint8_t v = static_cast<uint8_t>(static_cast<int>(value + 128.0) & 0xFF); std::memcpy(dst, &v, 1); } break; 
+                case BENCH_INT16: { int16_t v = static_cast<int16_t>(value * 10.0); std::memcpy(dst, &v, 2); } break; 
+                case BENCH_UINT16: { uint16_t v = static_cast<uint16_t>(value * 10.0 + 2000.0); std::memcpy(dst, &v, 2); } break; 
+                case BENCH_INT32: { int32_t v = static_cast<int32_t>(value * 1000.0); std::memcpy(dst, &v, 4); } break; 
+                case BENCH_FLOAT32: { float v = static_cast<float>(value); std::memcpy(dst, &v, 4); } break; 
+                case BENCH_FLOAT64: { double v = value; std::memcpy(dst, &v, 8); } break; 
+                }
+            }
+        }
+    }
+}
+
+static bool WriteFile(const std::string& path, const std::string& header, const std::vector<unsigned char>& payload)
+{
+    std::ofstream outputStream(path.c_str(), std::ios::out | std::ios::binary); 
+    outputStream.write(header.data(), header.size()); 
+    outputStream.write(reinterpret_cast<const char*>(payload.data()), payload.size()); 
+    return outputStream.good(); 
+}
+
+static bool WriteGzipFile(const std::string& path, const std::string& header, const std::vector<unsigned char>& payload, bool headerCompressed)
+{
+    std::string prefix = headerCompressed ? std::string() : header; 
+    if(!WriteFile(path, prefix, std::vector<unsigned char>())){
+        return false; 
+    }
+
+    //appended as a gzip member after the plain header, or the whole file: 
+    gzFile file = gzopen(path.c_str(), "ab6"); 
+    if(file == NULL){
+        return false; 
+    }
+    bool isWritten = true; 
+    if(headerCompressed){
+        isWritten = gzwrite(file, header.data(), static_cast<unsigned>(header.size())) == static_cast<int>(header.size()); 
+    }
+    size_t offset = 0; 
+    while(isWritten && offset < payload.size()){
+        unsigned chunk = static_cast<unsigned>(std::min<size_t>(payload.size() - offset, 1 << 30)); 
+        isWritten = gzwrite(file, payload.data() + offset, chunk) == static_cast<int>(chunk); 
+        offset += chunk; 
+    }
+    return (gzclose(file) == Z_OK) && isWritten; 
+}
+
+//NIfTI-1 single file, sform with 0.5 x 0.75 x 2 mm voxels: 
+static bool WriteNifti(const BenchCase& benchCase, const std::vector<unsigned char>& payload)
+{
+    short datatype = 0; 
+    switch (benchCase.type)
+    {
+    case BENCH_UINT8: datatype = 2; break; 
+    case BENCH_INT16: datatype = 4; break; 
+    case BENCH_UINT16: datatype = 512; break; 
+    case BENCH_INT32: datatype = 8; break; 
+    case BENCH_FLOAT32: datatype = 16; break; 
+    case BENCH_FLOAT64: datatype = 64; break; 
+    }
+
+    std::vector<char> header(352, 0); 
+    int32_t sizeofHeader = 348; 
+    short dims[8] = {3, static_cast<short>(benchCase.dim[0]), static_cast<short>(benchCase.dim[1]), static_cast<short>(benchCase.dim[2]), 1, 1, 1, 1}; 
+    short bitpix = static_cast<short>(BenchTypeSize(benchCase.type) * 8); 
+    float pixdim[8] = {1.0f, 0.5f, 0.75f, 2.0f, 1.0f, 1.0f, 1.0f, 1.0f}; 
+    float voxOffset = 352.0f; 
+    short sformCode = 1; 
+    float srow[12] = {0.5f, 0.0f, 0.0f, -10.0f, 0.0f, 0.75f, 0.0f, -20.0f, 0.0f, 0.0f, 2.0f, -30.0f}; 
+    std::memcpy(&header[0], &sizeofHeader, 4); 
+    std::memcpy(&header[40], dims, sizeof(dims)); 
+    std::memcpy(&header[70], &datatype, 2); 
+    std::memcpy(&header[72], &bitpix, 2); 
+    std::memcpy(&header[76], pixdim, sizeof(pixdim)); 
+    std::memcpy(&header[108], &voxOffset, 4); 
+    std::memcpy(&header[254], &sformCode, 2); 
+    std::memcpy(&header[280], srow, sizeof(srow)); 
+    std::memcpy(&header[344], "n+1\0", 4); 
+
+    std::string headerBytes(header.begin(), header.end()); 
+    if(benchCase.encoding == "gzip"){
+        return WriteGzipFile(benchCase.path, headerBytes, payload, true); 
+    }
+    return WriteFile(benchCase.path, headerBytes, payload); 
+}
+
+static bool WriteNrrd(const BenchCase& benchCase, const std::vector<unsigned char>& payload)
+{
+    const char *typeName = "short"; 
+    switch (benchCase.type)
+    {
+    case BENCH_UINT8: typeName = "unsigned char"; break; 
+    case BENCH_INT16: typeName = "short"; break; 
+    case BENCH_UINT16: typeName = "unsigned short"; break; 
+    case BENCH_INT32: typeName = "int"; break; 
+    case BENCH_FLOAT32: typeName = "float"; break; 
+    case BENCH_FLOAT64: typeName = "double"; break; 
+    }
+
+    std::ostringstream header; 
+    header << "NRRD0004\n" << "type: " << typeName << "\n" << "dimension: 3\n"
+        << "space: left-posterior-superior\n"
+        << "sizes: " << benchCase.dim[0] << " " << benchCase.dim[1] << " " << benchCase.dim[2] << "\n"
+        << "space directions: (0.5,0,0) (0,0.75,0) (0,0,2)\n"
+        << "endian: little\n" << "encoding: " << benchCase.encoding << "\n"
+        << "space origin: (-10,-20,-30)\n\n"; 
+
+    if(benchCase.encoding == "gzip"){
+        return WriteGzipFile(benchCase.path, header.str(), payload, false); 
+    }
+    if(benchCase.encoding == "ascii"){
+        std::ostringstream text; 
+        text << std::setprecision(9); 
+        size_t voxelBytes = BenchTypeSize(benchCase.type); 
+        for(size_t idx = 0; idx < payload.size() / voxelBytes; ++idx){
+            const unsigned char *src = payload.data() + idx * voxelBytes; 
+            switch (benchCase.type)
+            {
+            case BENCH_UINT8: text << static_cast<int>(*src); break; 
+            case BENCH_INT16: { int16_t v; std::memcpy(&v, src, 2); text << v; } break; 
+            case BENCH_UINT16: { uint16_t v; std::memcpy(&v, src, 2); text << v; } break; 
+            case BENCH_INT32: { int32_t v; std::memcpy(&v, src, 4); text << v; } break; 
+            case BENCH_FLOAT32: { float v; std::memcpy(&v, src, 4); text << v; } break; 
+            case BENCH_FLOAT64: { double v; std::memcpy(&v, src, 8); text << v; } break; 
+            }
+            text << ((idx % 16 == 15) ? '\n' : ' '); 
+        }
+        std::string textPayload = text.str(); 
+        return WriteFile(benchCase.path, header.str() + textPayload, std::vector<unsigned char>()); 
+    }
+    return WriteFile(benchCase.path, header.str(), payload); 
+}
+
+//explicit VR little endian element: 
+static void AppendDicomElement(std::string& body, uint16_t group, uint16_t element, const char *vr, const std::string& value)
+{
+    std::string padded = value; 
+    if(padded.size() % 2){
+        padded += (std::strcmp(vr, "UI") == 0) ? '\0' : ' '; 
+    }
+
+    body.append(reinterpret_cast<const char*>(&group), 2); 
+    body.append(reinterpret_cast<const char*>(&element), 2); 
+    body.append(vr, 2); 
+    if(std::strcmp(vr, "OB") == 0 || std::strcmp(vr, "OW") == 0){
+        uint32_t length = static_cast<uint32_t>(padded.size()); 
+        body.append(2, '\0'); 
+        body.append(reinterpret_cast<const char*>(&length), 4); 
+    }
+    else{
+        uint16_t length = static_cast<uint16_t>(padded.size()); 
+        body.append(reinterpret_cast<const char*>(&length), 2); 
+    }
+    body += padded; 
+}
+
+static std::string DicomUnsignedShort(uint16_t value)
+{
+    return std::string(reinterpret_cast<const char*>(&value), 2); 
+}
+
+//multi-frame CT, one frame per slice, int16 or unsigned 8 / 16 bit (PixelRepresentation 0): 
+static bool WriteDicom(const BenchCase& benchCase, const std::vector<unsigned char>& payload)
+{
+    uint16_t bitsAllocated = static_cast<uint16_t>(BenchTypeSize(benchCase.type) * 8); 
+    uint16_t pixelRepresentation = (benchCase.type == BENCH_INT16) ? 1 : 0; 
+
+    std::string body; 
+    AppendDicomElement(body, 0x0002, 0x0010, "UI", "1.2.840.10008.1.2.1"); 
+    AppendDicomElement(body, 0x0008, 0x0018, "UI", "1.2.826.0.1.3680043.2.1125.1"); 
+    AppendDicomElement(body, 0x0008, 0x0060, "CS", "CT"); 
+    AppendDicomElement(body, 0x0018, 0x0050, "DS", "2.0"); 
+    AppendDicomElement(body, 0x0020, 0x000e, "UI", "1.2.826.0.1.3680043.2.1125.2"); 
+    AppendDicomElement(body, 0x0020, 0x0013, "IS", "1"); 
+    AppendDicomElement(body, 0x0020, 0x0032, "DS", "-10\\-20\\-30"); 
+    AppendDicomElement(body, 0x0020, 0x0037, "DS", "1\\0\\0\\0\\1\\0"); 
+    AppendDicomElement(body, 0x0028, 0x0008, "IS", std::to_string(benchCase.dim[2])); 
+    AppendDicomElement(body, 0x0028, 0x0010, "US", DicomUnsignedShort(static_cast<uint16_t>(benchCase.dim[1]))); 
+    AppendDicomElement(body, 0x0028, 0x0011, "US", DicomUnsignedShort(static_cast<uint16_t>(benchCase.dim[0]))); 
+    AppendDicomElement(body, 0x0028, 0x0030, "DS", "0.75\\0.5"); 
+    AppendDicomElement(body, 0x0028, 0x0100, "US", DicomUnsignedShort(bitsAllocated)); 
+    AppendDicomElement(body, 0x0028, 0x0101, "US", DicomUnsignedShort(bitsAllocated)); 
+    AppendDicomElement(body, 0x0028, 0x0102, "US", DicomUnsignedShort(static_cast<uint16_t>(bitsAllocated - 1))); 
+    AppendDicomElement(body, 0x0028, 0x0103, "US", DicomUnsignedShort(pixelRepresentation)); 
+    AppendDicomElement(body, 0x7fe0, 0x0010, (bitsAllocated == 8) ? "OB" : "OW", std::string(payload.begin(), payload.end())); 
+
+    return WriteFile(benchCase.path, std::string(128, '\0') + "DICM" + body, std::vector<unsigned char>()); 
+}
+
+static bool WriteCase(const BenchCase& benchCase)
+{
+    std::vector<unsigned char> payload; 
+    SynthesizeVoxels(benchCase.type, benchCase.dim, payload); 
+    if(benchCase.format == "nii"){
+        return WriteNifti(benchCase, payload); 
+    }
+    if(benchCase.format == "nrrd"){
+        return WriteNrrd(benchCase, payload); 
+    }
+    return WriteDicom(benchCase, payload); 
+}
+
+
+/* ------------------------------ Measurement ---------------------------- */ 
+struct BenchResult{
+    double headerMs; 
+    double decodeMs; 
+    double inflateMs; 
+    double convertMs; 
+    double totalMs; 
+    long peakRssKb; 
+    int isRead; 
+    int isMeasured; 
+}; 
+
+static double MilliSeconds(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count(); 
+}
+
+static double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end()); 
+    return values.empty() ? 0.0 : values[values.size() / 2]; 
+}
+
+//median over the repeats of each stage, reader output is silenced: 
+static BenchResult MeasureCase(const BenchCase& benchCase, int repeats, int numThreads)
+{
+    std::vector<double> header, decode, inflate, convert, total; 
+    BenchResult result; 
+    result.isRead = 1; 
+    result.isMeasured = 1; 
+
+    std::streambuf *console = std::cout.rdbuf(); 
+    std::ostringstream discard; 
+    std::cout.rdbuf(discard.rdbuf()); 
+    for(int idx = 0; idx < repeats; ++idx){
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now(); 
+        MedicalImageIO headerIO(benchCase.path); 
+        result.isRead &= headerIO.ReadHeader() ? 1 : 0; 
+        header.push_back(MilliSeconds(begin)); 
+
+        MedicalImageIO stagedIO(benchCase.path); 
+        stagedIO.SetNumberOfThreads(numThreads); 
+        begin = std::chrono::steady_clock::now(); 
+        result.isRead &= stagedIO.ReadNative() ? 1 : 0; 
+        decode.push_back(MilliSeconds(begin)); 
+        inflate.push_back(stagedIO.GetReadStats().inflateMs); 
+        begin = std::chrono::steady_clock::now(); 
+        result.isRead &= (stagedIO.GetRawBuffer() != NULL) ? 1 : 0; 
+        convert.push_back(MilliSeconds(begin)); 
+
+        MedicalImageIO totalIO(benchCase.path); 
+        totalIO.SetNumberOfThreads(numThreads); 
+        begin = std::chrono::steady_clock::now(); 
+        result.isRead &= totalIO.Read() ? 1 : 0; 
+        total.push_back(MilliSeconds(begin)); 
+    }
+    std::cout.rdbuf(console); 
+
+    result.headerMs = Median(header); 
+    result.decodeMs = Median(decode); 
+    result.inflateMs = Median(inflate); 
+    result.convertMs = Median(convert); 
+    result.totalMs = Median(total); 
+    result.peakRssKb = 0; 
+#ifndef _WIN32
+    struct rusage usage; 
+    if(getrusage(RUSAGE_SELF, &usage) == 0){
+        result.peakRssKb = usage.ru_maxrss; 
+    }
+#endif
+    return result; 
+}
+
+//in a child process, so that ru_maxrss is the peak of this reader only. The parent never reads, 
+//its thread pool would be inherited by later children; a case that cannot be forked is reported failed: 
+static BenchResult RunCase(const BenchCase& benchCase, int repeats, int numThreads)
+{
+    BenchResult result; 
+    std::memset(&result, 0, sizeof(result)); 
+#ifndef _WIN32
+    int channel[2]; 
+    if(pipe(channel) != 0){
+        return result; 
+    }
+    std::cout.flush(); 
+    pid_t child = fork(); 
+    if(child == 0){
+        close(channel[0]); 
+        BenchResult childResult = MeasureCase(benchCase, repeats, numThreads); 
+        ssize_t written = write(channel[1], &childResult, sizeof(childResult)); 
+        _exit(written == static_cast<ssize_t>(sizeof(childResult)) ? 0 : 1); 
+    }
+    close(channel[1]); 
+
+    bool isReceived = (child > 0) && read(channel[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result)); 
+    close(channel[0]); 
+    if(child > 0){
+        int status = 0; 
+        waitpid(child, &status, 0); 
+    }
+    if(!isReceived){
+        std::memset(&result, 0, sizeof(result)); 
+    }
+    return result; 
+#else
+    return MeasureCase(benchCase, repeats, numThreads); 
+#endif
+}
+
+
+/* ------------------------------ Main ---------------------------- */ 
+static std::vector<int> ParseSizes(const std::string& text)
+{
+    std::vector<int> sizes; 
+    std::stringstream stream(text); 
+    std::string item; 
+    while(std::getline(stream, item, ',')){
+        int size = std::atoi(item.c_str()); 
+        if(size > 0){
+            sizes.push_back(size); 
+        }
+    }
+    return sizes; 
+}
+
+int main(int argc, char *argv[]){
+
+    std::vector<int> sizes = {64, 192}; 
+    int repeats = 5; 
+    int numThreads = 0; 
+    std::string directory = "MedImgBench_data"; 
+    bool csv = false; 
+    bool keep = false; 
+
+    for(int idx = 1; idx < argc; ++idx){
+        std::string option(argv[idx]); 
+        if(option == "--sizes" && idx + 1 < argc){
+            sizes = ParseSizes(argv[++idx]); 
+        }
+        else if(option == "--repeats" && idx + 1 < argc){
+            repeats = std::max(1, std::atoi(argv[++idx])); 
+        }
+        else if(option == "--threads" && idx + 1 < argc){
+            numThreads = std::atoi(argv[++idx]); 
+        }
+        else if(option == "--dir" && idx + 1 < argc){
+            directory = argv[++idx]; 
+        }
+        else if(option == "--csv"){
+            csv = true; 
+        }
+        else if(option == "--keep"){
+            keep = true; 
+        }
+        else{
+            std::cout << "Usage: MedImgBench [--sizes 64,192] [--repeats 5] [--threads 0] [--dir PATH] [--csv] [--keep]" << std::endl; 
+            return 1; 
+        }
+    }
+
+#ifndef _WIN32
+    mkdir(directory.c_str(), 0755); 
+#endif
+
+    //formats x encodings x voxel types, cubes of every size (z capped by the 16 bit NIfTI-1 dims): 
+    std::vector<BenchCase> cases; 
+    const BenchType allTypes[] = {BENCH_UINT8, BENCH_INT16, BENCH_UINT16, BENCH_INT32, BENCH_FLOAT32, BENCH_FLOAT64}; 
+    const BenchType nrrdTypes[] = {BENCH_INT16, BENCH_FLOAT32}; 
+    const BenchType dicomTypes[] = {BENCH_UINT8, BENCH_INT16, BENCH_UINT16}; 
+    for(size_t idxSize = 0; idxSize < sizes.size(); ++idxSize){
+        BenchCase benchCase; 
+        benchCase.dim[0] = sizes[idxSize]; benchCase.dim[1] = sizes[idxSize]; benchCase.dim[2] = sizes[idxSize]; 
+
+        for(const BenchType& type : allTypes){
+            benchCase.type = type; 
+            benchCase.format = "nii"; 
+            benchCase.encoding = "raw"; 
+            cases.push_back(benchCase); 
+            benchCase.encoding = "gzip"; 
+            cases.push_back(benchCase); 
+        }
+        for(const BenchType& type : nrrdTypes){
+            benchCase.type = type; 
+            benchCase.format = "nrrd"; 
+            for(const char *encoding : {"raw", "gzip", "bzip2", "ascii"}){
+                benchCase.encoding = encoding; 
+                cases.push_back(benchCase); 
+            }
+        }
+        for(const BenchType& type : dicomTypes){
+            benchCase.type = type; 
+            benchCase.format = "dcm"; 
+            benchCase.encoding = "raw"; 
+            cases.push_back(benchCase); 
+        }
+    }
+
+    if(csv){
+        std::cout << "format,encoding,type,dimX,dimY,dimZ,file_mb,header_ms,decode_ms,inflate_ms,convert_ms,total_ms,output_mb_s,peak_rss_mb" << std::endl; 
+    }
+    else{
+        std::cout << std::left << std::setw(7) << "format" << std::setw(7) << "enc" << std::setw(8) << "type"
+            << std::right << std::setw(14) << "dims" << std::setw(10) << "file MB" << std::setw(10) << "header"
+            << std::setw(10) << "decode" << std::setw(10) << "inflate" << std::setw(10) << "convert" << std::setw(10) << "total"
+            << std::setw(10) << "MB/s" << std::setw(10) << "RSS MB" << std::endl; 
+    }
+
+    for(size_t idx = 0; idx < cases.size(); ++idx){
+        BenchCase& benchCase = cases[idx]; 
+        std::ostringstream name; 
+        name << directory << "/" << benchCase.format << "_" << benchCase.encoding << "_" << BenchTypeName(benchCase.type)
+            << "_" << benchCase.dim[0] << "x" << benchCase.dim[1] << "x" << benchCase.dim[2]; 
+        name << ((benchCase.format == "nii") ? (benchCase.encoding == "gzip" ? ".nii.gz" : ".nii") : "." + benchCase.format); 
+        benchCase.path = name.str(); 
+
+        std::ostringstream dims; 
+        dims << benchCase.dim[0] << "x" << benchCase.dim[1] << "x" << benchCase.dim[2]; 
+
+        //bzip2 is only there if NrrdIO was built with it: 
+        bool isAvailable = !(benchCase.format == "nrrd" && benchCase.encoding == "bzip2" && !nrrdEncodingBzip2->available()); 
+        bool isWritten = isAvailable && WriteCase(benchCase); 
+        BenchResult result; 
+        std::memset(&result, 0, sizeof(result)); 
+        if(isWritten){
+            result = RunCase(benchCase, repeats, numThreads); 
+        }
+        if(!result.isMeasured){
+            std::string reason = !isAvailable ? "not available in this build" : (isWritten ? "failed to run" : "failed to write"); 
+            if(csv){
+                std::cout << benchCase.format << "," << benchCase.encoding << "," << BenchTypeName(benchCase.type)
+                    << "," << benchCase.dim[0] << "," << benchCase.dim[1] << "," << benchCase.dim[2] << ",,,,,,,," << std::endl; 
+            }
+            else{
+                std::cout << std::left << std::setw(7) << benchCase.format << std::setw(7) << benchCase.encoding
+                    << std::setw(8) << BenchTypeName(benchCase.type) << std::right << std::setw(14) << dims.str()
+                    << "    " << reason << std::endl; 
+            }
+            if(isWritten && !keep){
+                std::remove(benchCase.path.c_str()); 
+            }
+            continue; 
+        }
+
+        double fileMb = 0.0; 
+#ifndef _WIN32
+        struct stat fileStat; 
+        if(stat(benchCase.path.c_str(), &fileStat) == 0){
+            fileMb = fileStat.st_size / 1048576.0; 
+        }
+#endif
+
+        double outputMb = static_cast<double>(benchCase.dim[0]) * benchCase.dim[1] * benchCase.dim[2] * sizeof(float) / 1048576.0; 
+        double throughput = (result.totalMs > 0.0) ? outputMb / (result.totalMs / 1000.0) : 0.0; 
+        double rssMb = result.peakRssKb / 1024.0; 
+
+        if(csv){
+            std::cout << std::fixed << std::setprecision(3)
+                << benchCase.format << "," << benchCase.encoding << "," << BenchTypeName(benchCase.type) << ","
+                << benchCase.dim[0] << "," << benchCase.dim[1] << "," << benchCase.dim[2] << ","
+                << fileMb << "," << result.headerMs << "," << result.decodeMs << "," << result.inflateMs << "," << result.convertMs << ","
+                << result.totalMs << "," << throughput << "," << rssMb << std::endl; 
+        }
+        else{
+            std::cout << std::fixed << std::setprecision(2)
+                << std::left << std::setw(7) << benchCase.format << std::setw(7) << benchCase.encoding
+                << std::setw(8) << BenchTypeName(benchCase.type) << std::right << std::setw(14) << dims.str()
+                << std::setw(10) << fileMb << std::setw(10) << result.headerMs << std::setw(10) << result.decodeMs
+                << std::setw(10) << result.inflateMs << std::setw(10) << result.convertMs << std::setw(10) << result.totalMs
+                << std::setw(10) << throughput << std::setw(10) << rssMb
+                << (result.isRead ? "" : "    read failed") << std::endl; 
+        }
+
+        if(!keep){
+            std::remove(benchCase.path.c_str()); 
+        }
+    }
+
+    if(!keep){
+#ifndef _WIN32
+        rmdir(directory.c_str()); 
+#endif
+    }
+
+    return 0; 
+}
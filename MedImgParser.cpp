@@ -4,8 +4,29 @@
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "utilities.h"
+#include "ParallelGzip.h"
+#include "VoxelConvert.h"
+#include "BufferPool.h"
+#include "VolumeCache.h"
+#include "ThreadPool.h"
+#include "ReadStats.h"
 
 //includes: 
 #include "nifti2_io.h"
@@ -15,6 +36,449 @@
 namespace MedImageParser
 {
 
+/* ------------------------------ Native voxel view ---------------------------- */ 
+size_t VoxelTypeSize(VoxelType type)
+{
+    switch (type)
+    {
+    case VOXEL_UINT8: 
+    case VOXEL_INT8: 
+        return 1; 
+    case VOXEL_UINT16: 
+    case VOXEL_INT16: 
+        return 2; 
+    case VOXEL_UINT32: 
+    case VOXEL_INT32: 
+    case VOXEL_FLOAT32: 
+        return 4; 
+    case VOXEL_FLOAT64: 
+        return 8; 
+    default:
+        return 0; 
+    }
+}
+
+const char* VoxelTypeName(VoxelType type)
+{
+    switch (type)
+    {
+    case VOXEL_UINT8: return "uint8"; 
+    case VOXEL_INT8: return "int8"; 
+    case VOXEL_UINT16: return "uint16"; 
+    case VOXEL_INT16: return "int16"; 
+    case VOXEL_UINT32: return "uint32"; 
+    case VOXEL_INT32: return "int32"; 
+    case VOXEL_FLOAT32: return "float32"; 
+    case VOXEL_FLOAT64: return "float64"; 
+    default: return "unknown"; 
+    }
+}
+
+VolumeView::VolumeView()
+{
+    data = NULL; 
+    type = VOXEL_UNKNOWN; 
+    dim[0] = 0; dim[1] = 0; dim[2] = 0; dim[3] = 1; 
+    stride[0] = 0; stride[1] = 0; stride[2] = 0; stride[3] = 0; 
+    byteSwapped = false; 
+    slope = 1.0f; 
+    intercept = 0.0f; 
+    bitsStored = 0; 
+}
+
+bool VolumeView::IsValid() const
+{
+    return data != NULL && type != VOXEL_UNKNOWN; 
+}
+
+size_t VolumeView::NumberOfVoxels() const
+{
+    return static_cast<size_t>(dim[0]) * static_cast<size_t>(dim[1]) * static_cast<size_t>(dim[2]) * static_cast<size_t>(dim[3]); 
+}
+
+//volumes and slices are both just more rows: 
+static int NumberOfRows(const VolumeView& view)
+{
+    return view.dim[1] * view.dim[2] * view.dim[3]; 
+}
+
+//rows [firstRow, lastRow), output points at the first of them. 
+//packed rows go through the vectorized row kernels, other strides voxel by voxel: 
+static void ConvertRowsToFloat(const VolumeView& view, int firstRow, int lastRow, float slope, float intercept, float* output)
+{
+    const int dimX = view.dim[0]; 
+    const bool packed = (view.stride[0] == static_cast<std::ptrdiff_t>(VoxelTypeSize(view.type))); 
+
+    for(int idxRow = firstRow; idxRow < lastRow; ++idxRow){
+        int idxY = idxRow % view.dim[1]; 
+        int idxZ = (idxRow / view.dim[1]) % view.dim[2]; 
+        int idxVolume = idxRow / (view.dim[1] * view.dim[2]); 
+        const unsigned char* srcRow = view.data + idxVolume * view.stride[3] + idxZ * view.stride[2] + idxY * view.stride[1]; 
+        float* dstRow = output + static_cast<size_t>(idxRow - firstRow) * dimX; 
+
+        if(packed){
+            ConvertVoxelRow(view.type, srcRow, dimX, view.byteSwapped, slope, intercept, dstRow, view.bitsStored); 
+            continue; 
+        }
+        for(int idxX = 0; idxX < dimX; ++idxX){
+            ConvertVoxelRow(view.type, srcRow + idxX * view.stride[0], 1, view.byteSwapped, slope, intercept, dstRow + idxX, view.bitsStored); 
+        }
+    }
+}
+
+//smallest slab worth a task: 
+static const size_t minSlabVoxels = 262144; 
+
+//number of threads a conversion of the view actually uses: 
+static int ConversionThreads(const VolumeView& view, int numThreads)
+{
+    size_t numSlabs = std::max<size_t>(view.NumberOfVoxels() / minSlabVoxels, 1); 
+    return static_cast<int>(std::min<size_t>(PoolThreads(numThreads), numSlabs)); 
+}
+
+//Row slabs converted in parallel. Each slab of the output is first touched by 
+//the thread converting it, so its pages are placed on that thread's NUMA node: 
+static void ConvertRowsParallel(const VolumeView& view, float slope, float intercept, float* output, int numThreads)
+{
+    const int numRows = NumberOfRows(view); 
+    //about four slabs per thread keeps the threads balanced: 
+    const int slabRows = std::max(numRows / (numThreads * 4), 1); 
+    const int numSlabs = (numRows + slabRows - 1) / slabRows; 
+
+    RunParallel(numSlabs, numThreads, [&](int slab){
+        int firstRow = slab * slabRows; 
+        int lastRow = std::min(firstRow + slabRows, numRows); 
+        ConvertRowsToFloat(view, firstRow, lastRow, slope, intercept, output + static_cast<size_t>(firstRow) * view.dim[0]); 
+    }); 
+}
+
+bool ConvertToFloat(const VolumeView& view, float* output)
+{
+    return ConvertToFloat(view, output, false); 
+}
+
+bool ConvertToFloat(const VolumeView& view, float* output, bool applyScaling, int numThreads)
+{
+    if(!view.IsValid() || output == NULL){
+        std::cout << "ERROR: Invalid volume view. " << std::endl; 
+        return false; 
+    }
+
+    //the scaling rides along in the widening pass: 
+    float slope = applyScaling ? view.slope : 1.0f; 
+    float intercept = applyScaling ? view.intercept : 0.0f; 
+
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    numThreads = ConversionThreads(view, numThreads); 
+    if(numThreads > 1){
+        ConvertRowsParallel(view, slope, intercept, output, numThreads); 
+    }
+    else{
+        ConvertRowsToFloat(view, 0, NumberOfRows(view), slope, intercept, output); 
+    }
+    timer.toc(); 
+    RecordConvert(view.NumberOfVoxels() * sizeof(float), timer.Duration()); 
+    return true; 
+}
+
+bool ConvertToFloat(const VolumeView& view, FloatBuffer& output, bool applyScaling, int numThreads)
+{
+    if(!view.IsValid()){
+        std::cout << "ERROR: Invalid volume view. " << std::endl; 
+        return false; 
+    }
+
+    if(output.capacity() < view.NumberOfVoxels()){
+        RecordAllocation(view.NumberOfVoxels() * sizeof(float), false); 
+    }
+
+    //resize() leaves the floats unwritten, each slab's pages are first touched by its converting thread: 
+    output.resize(view.NumberOfVoxels()); 
+    return ConvertToFloat(view, output.data(), applyScaling, numThreads); 
+}
+
+//contiguous x-fastest layout: 
+static void SetPackedStrides(VolumeView& view)
+{
+    std::ptrdiff_t voxelBytes = static_cast<std::ptrdiff_t>(VoxelTypeSize(view.type)); 
+    view.stride[0] = voxelBytes; 
+    view.stride[1] = voxelBytes * view.dim[0]; 
+    view.stride[2] = voxelBytes * view.dim[0] * view.dim[1]; 
+    view.stride[3] = view.stride[2] * view.dim[2]; 
+}
+
+static VoxelType NiftiVoxelType(int datatype)
+{
+    switch (datatype)
+    {
+    case DT_UINT8: return VOXEL_UINT8; 
+    case DT_INT8: return VOXEL_INT8; 
+    case DT_UINT16: return VOXEL_UINT16; 
+    case DT_INT16: return VOXEL_INT16; 
+    case DT_UINT32: return VOXEL_UINT32; 
+    case DT_INT32: return VOXEL_INT32; 
+    case DT_FLOAT32: return VOXEL_FLOAT32; 
+    case DT_FLOAT64: return VOXEL_FLOAT64; 
+    default: return VOXEL_UNKNOWN; 
+    }
+}
+
+static VoxelType NrrdVoxelType(int type)
+{
+    switch (type)
+    {
+    case nrrdTypeUChar: return VOXEL_UINT8; 
+    case nrrdTypeChar: return VOXEL_INT8; 
+    case nrrdTypeUShort: return VOXEL_UINT16; 
+    case nrrdTypeShort: return VOXEL_INT16; 
+    case nrrdTypeUInt: return VOXEL_UINT32; 
+    case nrrdTypeInt: return VOXEL_INT32; 
+    case nrrdTypeFloat: return VOXEL_FLOAT32; 
+    case nrrdTypeDouble: return VOXEL_FLOAT64; 
+    default: return VOXEL_UNKNOWN; 
+    }
+}
+
+static void NiftiGeometry
+(
+    const nifti_image* niiImage, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ
+)
+{
+    //dimension: 
+    dimX = niiImage->nx; dimY = niiImage->ny; dimZ = niiImage->nz; 
+
+    //spacing: 
+    spacingX = niiImage->dx; spacingY = niiImage->dy; spacingZ = niiImage->dz; 
+
+    //origin: 
+    originX = niiImage->sto_xyz.m[0][3]; originY = niiImage->sto_xyz.m[1][3]; originZ = niiImage->sto_xyz.m[2][3]; 
+}
+
+static void NrrdGeometry
+(
+    const Nrrd* nrrdReader, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ
+)
+{
+    dimX = static_cast<int>(nrrdReader->axis[0].size); 
+    dimY = static_cast<int>(nrrdReader->axis[1].size); 
+    dimZ = static_cast<int>(nrrdReader->axis[2].size); 
+
+    int vectorIncrement=0;
+    if(nrrdReader->axis[0].kind==nrrdKindVector){
+        vectorIncrement=1;
+    }
+
+    double spaceDir[NRRD_SPACE_DIM_MAX], spacing;
+
+    nrrdSpacingCalculate(nrrdReader, vectorIncrement, &spacing, spaceDir); 
+    spacingX = spacing; 
+
+    nrrdSpacingCalculate(nrrdReader, 1 + vectorIncrement, &spacing, spaceDir); 
+    spacingY = spacing; 
+
+    nrrdSpacingCalculate(nrrdReader, 2 + vectorIncrement, &spacing, spaceDir); 
+    spacingZ = spacing; 
+
+    originX = static_cast<float>(nrrdReader->spaceOrigin[0]); 
+    originY = static_cast<float>(nrrdReader->spaceOrigin[1]); 
+    originZ = static_cast<float>(nrrdReader->spaceOrigin[2]); 
+}
+
+static void DicomGeometry
+(
+    DICOMPARSER_NAMESPACE::DICOMAppHelper* dicomReader, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ
+)
+{
+    spacingX = dicomReader->GetPixelSpacing()[0]; 
+    spacingY = dicomReader->GetPixelSpacing()[1]; 
+    spacingZ = dicomReader->GetPixelSpacing()[2]; 
+
+    dimX = dicomReader->GetDimensions()[0]; 
+    dimY = dicomReader->GetDimensions()[1]; 
+    dimZ = std::max(dicomReader->GetSliceNumber(), 1); 
+
+    originX = dicomReader->GetImagePositionPatient()[0]; 
+    originY = dicomReader->GetImagePositionPatient()[1]; 
+    originZ = dicomReader->GetImagePositionPatient()[2]; 
+}
+
+//voxel type as stored in the file, before any rescaling: 
+static VoxelType DicomStoredVoxelType(DICOMPARSER_NAMESPACE::DICOMAppHelper* dicomReader)
+{
+    bool isSigned = (dicomReader->GetPixelRepresentation() == 1); 
+    switch (dicomReader->GetBitsAllocated())
+    {
+    case 8: return isSigned ? VOXEL_INT8 : VOXEL_UINT8; 
+    case 16: return isSigned ? VOXEL_INT16 : VOXEL_UINT16; 
+    case 32: return isSigned ? VOXEL_INT32 : VOXEL_UINT32; 
+    default: return VOXEL_UNKNOWN; 
+    }
+}
+
+//unit direction of every index axis, column j of the row-major 3x3 matrix belongs to axis j: 
+static void NiftiDirection(const nifti_image* niiImage, float direction[9])
+{
+    const nifti_dmat44& xform = (niiImage->sform_code > 0) ? niiImage->sto_xyz : niiImage->qto_xyz; 
+
+    for(int col = 0; col < 3; ++col){
+        double norm = std::sqrt( 
+            xform.m[0][col] * xform.m[0][col] + 
+            xform.m[1][col] * xform.m[1][col] + 
+            xform.m[2][col] * xform.m[2][col]); 
+
+        for(int row = 0; row < 3; ++row){
+            if(norm > 0.0){
+                direction[row * 3 + col] = static_cast<float>(xform.m[row][col] / norm); 
+            }
+            else{
+                direction[row * 3 + col] = (row == col) ? 1.0f : 0.0f; 
+            }
+        }
+    }
+}
+
+//time points and vector components, every 3D volume after the first three dimensions: 
+static int NiftiNumberOfVolumes(const nifti_image* niiImage)
+{
+    int64_t numVolumes = 1; 
+    for(int idx = 4; idx <= niiImage->ndim && idx <= 7; ++idx){
+        numVolumes *= std::max<int64_t>(niiImage->dim[idx], 1); 
+    }
+    return static_cast<int>(numVolumes); 
+}
+
+//scl_slope 0 means unscaled, as do values that are not finite: 
+static void NiftiScaling(const nifti_image* niiImage, VolumeView& view)
+{
+    if(niiImage->scl_slope != 0.0 && std::isfinite(niiImage->scl_slope) && std::isfinite(niiImage->scl_inter)){
+        view.slope = static_cast<float>(niiImage->scl_slope); 
+        view.intercept = static_cast<float>(niiImage->scl_inter); 
+    }
+}
+
+static void NrrdDirection(const Nrrd* nrrdReader, float direction[9])
+{
+    int vectorIncrement=0;
+    if(nrrdReader->axis[0].kind==nrrdKindVector){
+        vectorIncrement=1;
+    }
+
+    double spaceDir[NRRD_SPACE_DIM_MAX], spacing;
+    for(int col = 0; col < 3; ++col){
+        int status = nrrdSpacingCalculate(nrrdReader, col + vectorIncrement, &spacing, spaceDir); 
+
+        for(int row = 0; row < 3; ++row){
+            if(status == nrrdSpacingStatusDirection && nrrdReader->spaceDim == 3){
+                direction[row * 3 + col] = static_cast<float>(spaceDir[row]); 
+            }
+            else{
+                direction[row * 3 + col] = (row == col) ? 1.0f : 0.0f; 
+            }
+        }
+    }
+}
+
+//ImageOrientationPatient, row cosine then column cosine: 
+static void OrientationDirection(const float orientation[6], float direction[9])
+{
+    const float* rowCosine = orientation; 
+    const float* colCosine = orientation + 3; 
+
+    //slice normal, row x column: 
+    float normal[3] = {
+        rowCosine[1] * colCosine[2] - rowCosine[2] * colCosine[1], 
+        rowCosine[2] * colCosine[0] - rowCosine[0] * colCosine[2], 
+        rowCosine[0] * colCosine[1] - rowCosine[1] * colCosine[0]
+    }; 
+
+    for(int row = 0; row < 3; ++row){
+        direction[row * 3 + 0] = rowCosine[row]; 
+        direction[row * 3 + 1] = colCosine[row]; 
+        direction[row * 3 + 2] = normal[row]; 
+    }
+}
+
+static void DicomDirection(DICOMPARSER_NAMESPACE::DICOMAppHelper* dicomReader, float direction[9])
+{
+    OrientationDirection(dicomReader->GetImageOrientationPatient(), direction); 
+}
+
+static bool RegionInside(const int dim[3], const int start[3], const int size[3])
+{
+    for(int axis = 0; axis < 3; ++axis){
+        if(start[axis] < 0 || size[axis] <= 0 || start[axis] > dim[axis] - size[axis]){
+            std::cout << "ERROR: Region is outside the image. " << std::endl; 
+            return false; 
+        }
+    }
+    return true; 
+}
+
+//same voxels, the view only starts at the region corner and stops at its size: 
+static VolumeView CropView(const VolumeView& view, const int start[3], const int size[3])
+{
+    VolumeView region = view; 
+    region.data = view.data + start[0] * view.stride[0] + start[1] * view.stride[1] + start[2] * view.stride[2]; 
+    region.dim[0] = size[0]; region.dim[1] = size[1]; region.dim[2] = size[2]; 
+    region.dim[3] = 1; 
+    return region; 
+}
+
+//size on disk, reported as bytes read by the decoders that read whole files: 
+static uint64_t FileBytes(const char *filename)
+{
+    struct stat fileStat; 
+    return (stat(filename, &fileStat) == 0) ? static_cast<uint64_t>(fileStat.st_size) : 0; 
+}
+
+//region of a packed, uncompressed payload, one seek and one read per row: 
+static bool ReadRawRegion
+(
+    FILE* file, long payloadOffset, 
+    const VolumeView& layout, 
+    const int start[3], const int size[3], 
+    FloatBuffer& ImageBuff
+)
+{
+    size_t voxelBytes = VoxelTypeSize(layout.type); 
+    size_t rowBytes = size[0] * voxelBytes; 
+    std::vector<unsigned char> regionBytes(rowBytes * size[1] * size[2]); 
+
+    unsigned char* rowBuffer = regionBytes.data(); 
+    for(int idxZ = start[2]; idxZ < start[2] + size[2]; ++idxZ){
+        for(int idxY = start[1]; idxY < start[1] + size[1]; ++idxY){
+            long rowOffset = payloadOffset + static_cast<long>(
+                idxZ * layout.stride[2] + idxY * layout.stride[1] + start[0] * layout.stride[0]); 
+            if(fseek(file, rowOffset, SEEK_SET) != 0 || fread(rowBuffer, 1, rowBytes, file) != rowBytes){
+                std::cout << "ERROR: Failed to read the image region. " << std::endl; 
+                return false; 
+            }
+            rowBuffer += rowBytes; 
+        }
+    }
+    RecordBytesRead(regionBytes.size()); 
+
+    VolumeView region; 
+    region.type = layout.type; 
+    region.dim[0] = size[0]; region.dim[1] = size[1]; region.dim[2] = size[2]; 
+    SetPackedStrides(region); 
+    region.data = regionBytes.data(); 
+    region.byteSwapped = layout.byteSwapped; 
+    region.bitsStored = layout.bitsStored; 
+
+    return ConvertToFloat(region, ImageBuff); 
+}
+
 /* ------------------------------ IO routine for NIfTI (Neuroimaging Informatics Technology Initiative) ---------------------------- */ 
 bool read_nii
 (   
@@ -22,228 +486,1356 @@ bool read_nii
     int& dimX, int& dimY, int& dimZ, 
     float& spacingX, float& spacingY, float& spacingZ, 
     float& originX, float& originY, float& originZ, 
-    std::vector<float>& ImageBuff
+    FloatBuffer& ImageBuff, bool applyScaling
+)
+{
+    VolumeView view; 
+    if(!read_nii(
+        filename, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ, 
+        view)){
+        return false; 
+    }
+
+    //ImageData: the view walks the rows bottom-up, so the type conversion, the 
+    //vertical convention correction and the intensity scaling happen in the same single pass: 
+    return ConvertToFloat(view, ImageBuff, applyScaling); 
+}
+
+bool read_nii
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VolumeView& view
+)
+{
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    nifti_image* niiImage = nifti_image_read(filename, false); 
+    timer.toc(); 
+    RecordHeader(timer.Duration()); 
+
+    if(niiImage == NULL){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+
+    VoxelType voxelType = NiftiVoxelType(niiImage->datatype); 
+    if(voxelType == VOXEL_UNKNOWN){
+        std::cout << "Data type cannot be recongnized! " << std::endl; 
+        nifti_image_free(niiImage); 
+        return false; 
+    }
+
+    std::unique_ptr<nifti_image, void(*)(nifti_image*)> niiHeader(niiImage, nifti_image_free); 
+
+    NiftiGeometry(
+        niiImage, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+
+    view = VolumeView(); 
+    view.type = voxelType; 
+    view.dim[0] = dimX; view.dim[1] = dimY; view.dim[2] = dimZ; 
+    view.dim[3] = NiftiNumberOfVolumes(niiImage); 
+    SetPackedStrides(view); 
+    NiftiScaling(niiImage, view); 
+
+    if(niiImage->iname == NULL || niiImage->iname_offset < 0){
+        std::cout << "File: " << filename << ", failed to read. " << std::endl; 
+        view = VolumeView(); 
+        return false; 
+    }
+
+    //the payload goes into a pooled buffer as stored, the view swaps the bytes while converting: 
+    timer.tic(); 
+    size_t payloadOffset = static_cast<size_t>(niiImage->iname_offset); 
+    size_t payloadLength = view.NumberOfVoxels() * VoxelTypeSize(voxelType); 
+    std::shared_ptr<unsigned char> payload; 
+    const unsigned char* voxels = NULL; 
+    if(nifti_is_gzfile(niiImage->iname)){
+        //gzip payload, inflated across threads instead of through znzlib: 
+        payload = AcquireBuffer(payloadOffset + payloadLength); 
+        if(!inflate_gz(niiImage->iname, payload.get(), payloadOffset + payloadLength)){
+            view = VolumeView(); 
+            return false; 
+        }
+        voxels = payload.get() + payloadOffset; 
+    }
+    else{
+        payload = AcquireBuffer(payloadLength); 
+        std::unique_ptr<FILE, int(*)(FILE*)> file(fopen(niiImage->iname, "rb"), fclose); 
+        if(!file || fseek(file.get(), static_cast<long>(payloadOffset), SEEK_SET) != 0 || 
+            fread(payload.get(), 1, payloadLength, file.get()) != payloadLength){
+            std::cout << "File: " << filename << ", failed to read. " << std::endl; 
+            view = VolumeView(); 
+            return false; 
+        }
+        RecordBytesRead(payloadLength); 
+        voxels = payload.get(); 
+    }
+    timer.toc(); 
+    RecordDecode(timer.Duration()); 
+    view.byteSwapped = (VoxelTypeSize(voxelType) > 1 && niiImage->byteorder != nifti_short_order()); 
+    view.owner = payload; 
+
+    //vertical convention corrected by walking the rows backwards, no copy: 
+    view.data = voxels + (dimY - 1) * view.stride[1]; 
+    view.stride[1] = -view.stride[1]; 
+
+    return true; 
+}
+
+bool map_nii
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VolumeView& view
+)
+{
+    //header only, the voxels are left on disk: 
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    nifti_image* niiImage = nifti_image_read(filename, false); 
+    if(niiImage == NULL){
+        return false; 
+    }
+    std::unique_ptr<nifti_image, void(*)(nifti_image*)> niiHeader(niiImage, nifti_image_free); 
+
+    VoxelType voxelType = NiftiVoxelType(niiImage->datatype); 
+    if(voxelType == VOXEL_UNKNOWN || niiImage->iname == NULL || nifti_is_gzfile(niiImage->iname)){
+        return false; 
+    }
+
+    std::shared_ptr<Utilities::MappedFile> mappedFile(new Utilities::MappedFile); 
+    if(!mappedFile->Open(niiImage->iname)){
+        return false; 
+    }
+
+    NiftiGeometry(
+        niiImage, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+
+    view = VolumeView(); 
+    view.type = voxelType; 
+    view.dim[0] = dimX; view.dim[1] = dimY; view.dim[2] = dimZ; 
+    view.dim[3] = NiftiNumberOfVolumes(niiImage); 
+    SetPackedStrides(view); 
+    NiftiScaling(niiImage, view); 
+
+    size_t payloadOffset = static_cast<size_t>(niiImage->iname_offset); 
+    if(niiImage->iname_offset < 0 || payloadOffset + view.NumberOfVoxels() * VoxelTypeSize(voxelType) > mappedFile->Size()){
+        view = VolumeView(); 
+        return false; 
+    }
+
+    //same bottom-up row walk as read_nii, straight out of the page cache: 
+    view.data = mappedFile->Data() + payloadOffset + (dimY - 1) * view.stride[1]; 
+    view.stride[1] = -view.stride[1]; 
+    view.byteSwapped = (VoxelTypeSize(voxelType) > 1 && niiImage->byteorder != nifti_short_order()); 
+    view.owner = mappedFile; 
+
+    //the mapped payload is paged in by the conversion: 
+    timer.toc(); 
+    RecordHeader(timer.Duration()); 
+    RecordBytesRead(view.NumberOfVoxels() * VoxelTypeSize(voxelType)); 
+    return true; 
+}
+
+bool read_nii_header
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VoxelType& voxelType, float direction[9], int& numberOfVolumes
+)
+{
+    //header only, the voxels are never read or inflated: 
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    nifti_image* niiImage = nifti_image_read(filename, false); 
+
+    if(niiImage == NULL){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+
+    NiftiGeometry(
+        niiImage, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+    NiftiDirection(niiImage, direction); 
+    voxelType = NiftiVoxelType(niiImage->datatype); 
+    numberOfVolumes = NiftiNumberOfVolumes(niiImage); 
+
+    nifti_image_free(niiImage); 
+    timer.toc(); 
+    RecordHeader(timer.Duration()); 
+    return true; 
+}
+
+bool read_nii_region
+(   
+    const char *filename, 
+    const int start[3], const int size[3], 
+    FloatBuffer& ImageBuff, bool applyScaling
+)
+{
+    nifti_image* niiImage = nifti_image_read(filename, false); 
+
+    if(niiImage == NULL){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+    std::unique_ptr<nifti_image, void(*)(nifti_image*)> niiHeader(niiImage, nifti_image_free); 
+
+    int dim[3] = {static_cast<int>(niiImage->nx), static_cast<int>(niiImage->ny), static_cast<int>(niiImage->nz)}; 
+    VoxelType voxelType = NiftiVoxelType(niiImage->datatype); 
+    if(voxelType == VOXEL_UNKNOWN){
+        std::cout << "Data type cannot be recongnized! " << std::endl; 
+        return false; 
+    }
+    if(!RegionInside(dim, start, size)){
+        return false; 
+    }
+
+    //rows are stored bottom-up, the region is read from the mirrored rows 
+    //and walked backwards like the whole volume: 
+    int64_t fileStart[7] = {start[0], dim[1] - start[1] - size[1], start[2], 0, 0, 0, 0}; 
+    int64_t fileSize[7] = {size[0], size[1], size[2], 1, 1, 1, 1}; 
+
+    //seek-and-read per row, compressed files seek through the gzip index: 
+    void* regionData = NULL; 
+    int64_t expectedBytes = static_cast<int64_t>(size[0]) * size[1] * size[2] * VoxelTypeSize(voxelType); 
+    int64_t readBytes = nifti_read_subregion_image(niiImage, fileStart, fileSize, &regionData); 
+    std::unique_ptr<void, void(*)(void*)> regionOwner(regionData, free); 
+    if(readBytes != expectedBytes){
+        std::cout << "File: " << filename << ", failed to read the image region. " << std::endl; 
+        return false; 
+    }
+    RecordBytesRead(readBytes); 
+
+    //nifti_read_subregion_image swaps the data to native order: 
+    VolumeView region; 
+    region.type = voxelType; 
+    region.dim[0] = size[0]; region.dim[1] = size[1]; region.dim[2] = size[2]; 
+    SetPackedStrides(region); 
+    region.data = static_cast<const unsigned char*>(regionData) + (size[1] - 1) * region.stride[1]; 
+    region.stride[1] = -region.stride[1]; 
+    NiftiScaling(niiImage, region); 
+
+    return ConvertToFloat(region, ImageBuff, applyScaling); 
+}
+
+/* ------------------------------ NIfTI volume stream ---------------------------- */ 
+NiftiVolumeStream::NiftiVolumeStream()
+{
+    file = NULL; 
+    dim[0] = 0; dim[1] = 0; dim[2] = 0; 
+    numTimepoints = 0; 
+    numComponents = 0; 
+    nextVolume = 0; 
+    payloadOffset = 0; 
+    filePosition = 0; 
+}
+
+NiftiVolumeStream::~NiftiVolumeStream()
+{
+    Close(); 
+}
+
+bool NiftiVolumeStream::Open(const char *filename)
+{
+    Close(); 
+
+    nifti_image* niiImage = nifti_image_read(filename, false); 
+    if(niiImage == NULL){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+    std::unique_ptr<nifti_image, void(*)(nifti_image*)> niiHeader(niiImage, nifti_image_free); 
+
+    VoxelType voxelType = NiftiVoxelType(niiImage->datatype); 
+    if(voxelType == VOXEL_UNKNOWN || niiImage->iname == NULL || niiImage->iname_offset < 0){
+        std::cout << "Data type cannot be recongnized! " << std::endl; 
+        return false; 
+    }
+
+    //one volume is read at a time, straight through znzlib: 
+    file = znzopen(niiImage->iname, "rb", nifti_is_gzfile(niiImage->iname)); 
+    if(znz_isnull(file)){
+        std::cout << "File: " << niiImage->iname << ", failed to open. " << std::endl; 
+        file = NULL; 
+        return false; 
+    }
+
+    float spacing[3], origin[3]; 
+    NiftiGeometry(
+        niiImage, 
+        dim[0], dim[1], dim[2], 
+        spacing[0], spacing[1], spacing[2], 
+        origin[0], origin[1], origin[2]); 
+
+    numTimepoints = static_cast<int>(std::max<int64_t>(niiImage->nt, 1)); 
+    numComponents = NiftiNumberOfVolumes(niiImage) / numTimepoints; 
+
+    //layout of one volume, rows walked bottom-up like read_nii: 
+    layout = VolumeView(); 
+    layout.type = voxelType; 
+    layout.dim[0] = dim[0]; layout.dim[1] = dim[1]; layout.dim[2] = dim[2]; 
+    SetPackedStrides(layout); 
+    layout.byteSwapped = (VoxelTypeSize(voxelType) > 1 && niiImage->byteorder != nifti_short_order()); 
+    NiftiScaling(niiImage, layout); 
+
+    payloadOffset = niiImage->iname_offset; 
+    filePosition = 0; 
+    nextVolume = 0; 
+    return true; 
+}
+
+void NiftiVolumeStream::Close()
+{
+    if(file != NULL){
+        znzclose(file); 
+        file = NULL; 
+    }
+    volumeBytes.clear(); 
+    nextVolume = 0; 
+}
+
+int NiftiVolumeStream::GetNumberOfVolumes() const
+{
+    return numTimepoints * numComponents; 
+}
+
+int NiftiVolumeStream::GetNumberOfTimepoints() const
+{
+    return numTimepoints; 
+}
+
+int NiftiVolumeStream::GetNumberOfComponents() const
+{
+    return numComponents; 
+}
+
+void NiftiVolumeStream::GetDimension(int _dim[3]) const
+{
+    _dim[0] = dim[0]; 
+    _dim[1] = dim[1]; 
+    _dim[2] = dim[2]; 
+}
+
+bool NiftiVolumeStream::Next(FloatBuffer& volume, bool applyScaling)
+{
+    if(nextVolume >= GetNumberOfVolumes()){
+        return false; 
+    }
+    return ReadVolume(nextVolume, volume, applyScaling); 
+}
+
+bool NiftiVolumeStream::ReadVolume(int index, FloatBuffer& volume, bool applyScaling)
+{
+    if(file == NULL || index < 0 || index >= GetNumberOfVolumes()){
+        std::cout << "ERROR: Volume " << index << " is not available. " << std::endl; 
+        return false; 
+    }
+
+    //sequential reads never seek, others go through the gzip index of .nii.gz files: 
+    size_t numBytes = layout.NumberOfVoxels() * VoxelTypeSize(layout.type); 
+    int64_t position = payloadOffset + static_cast<int64_t>(index) * numBytes; 
+    if(position != filePosition && znzseek(file, static_cast<long>(position), SEEK_SET) < 0){
+        std::cout << "ERROR: Failed to seek to volume " << index << ". " << std::endl; 
+        filePosition = -1; 
+        return false; 
+    }
+
+    volumeBytes.resize(numBytes); 
+    if(znzread(volumeBytes.data(), 1, numBytes, file) != numBytes){
+        std::cout << "ERROR: Failed to read volume " << index << ". " << std::endl; 
+        filePosition = -1; 
+        return false; 
+    }
+    filePosition = position + numBytes; 
+    nextVolume = index + 1; 
+
+    VolumeView view = layout; 
+    view.data = volumeBytes.data() + (dim[1] - 1) * layout.stride[1]; 
+    view.stride[1] = -layout.stride[1]; 
+
+    return ConvertToFloat(view, volume, applyScaling); 
+}
+
+/* ------------------------------ IO routine for DICOM ---------------------------- */ 
+//Pixel data callback of the DICOM reads. The stored voxels are handed to convert as a view 
+//on the parser's own buffer (the mapped file itself for mapped sources), with the rescale 
+//slope and intercept and Bits Stored, so they reach the caller's floats in one vectorized pass. 
+//Layouts the view cannot describe go to the app helper's callback in the same parse: 
+class DicomPixelReader{
+public:
+    DicomPixelReader(DICOMPARSER_NAMESPACE::DICOMAppHelper* reader, const std::function<bool(const VolumeView&)>& convert) : 
+        reader(reader), convert(convert), isHandled(false), isConverted(false), convertMs(0.0) {}
+
+    void PixelDataCallback(
+        DICOMPARSER_NAMESPACE::DICOMParser *parser, 
+        doublebyte group, 
+        doublebyte element, 
+        DICOMPARSER_NAMESPACE::DICOMParser::VRTypes type, 
+        unsigned char* data, 
+        quadbyte len)
+    {
+        //registered as OB, so the parser hands the data over unswapped: 
+        bool byteSwapped = reader->GetBitsAllocated() > 8 && 
+            (parser->GetToggleByteSwapImageData() ^ parser->GetDICOMFile()->GetPlatformIsBigEndian()); 
+
+        //encapsulated data (undefined length) and color images: 
+        VoxelType voxelType = DicomStoredVoxelType(reader); 
+        if(data == NULL || len < 0 || voxelType == VOXEL_UNKNOWN || reader->GetNumberOfComponents() != 1){
+            if(data != NULL && len > 0 && byteSwapped && reader->GetBitsAllocated() == 16){
+                //the helper expects swapped words, as it gets them when registered as OW: 
+                std::vector<unsigned char> swapped(data, data + len); 
+                for(size_t idx = 0; idx + 1 < swapped.size(); idx += 2){
+                    std::swap(swapped[idx], swapped[idx + 1]); 
+                }
+                reader->PixelDataCallback(parser, group, element, type, swapped.data(), len); 
+                return; 
+            }
+            reader->PixelDataCallback(parser, group, element, type, data, len); 
+            return; 
+        }
+        isHandled = true; 
+
+        VolumeView view; 
+        view.type = voxelType; 
+        view.dim[0] = reader->GetDimensions()[0]; 
+        view.dim[1] = reader->GetDimensions()[1]; 
+        view.dim[2] = std::max(reader->GetSliceNumber(), 1); 
+        if(view.NumberOfVoxels() * VoxelTypeSize(voxelType) > static_cast<size_t>(len)){
+            std::cout << "ERROR: Pixel data is shorter than the image dimension. " << std::endl; 
+            return; 
+        }
+
+        SetPackedStrides(view); 
+        view.data = data; 
+        view.byteSwapped = byteSwapped; 
+        view.slope = reader->GetRescaleSlope(); 
+        view.intercept = reader->GetRescaleOffset(); 
+        view.bitsStored = reader->GetBitsStored(); 
+
+        Utilities::MyTimer timer; 
+        timer.tic(); 
+        isConverted = convert(view); 
+        timer.toc(); 
+        convertMs = timer.Duration(); 
+    }
+
+    DICOMPARSER_NAMESPACE::DICOMAppHelper* reader; 
+    const std::function<bool(const VolumeView&)>& convert; 
+    //isHandled once the pixel data was found in a layout the view describes: 
+    bool isHandled; 
+    bool isConverted; 
+    double convertMs; 
+}; 
+
+//Parses the file once and passes its voxels to convert, which applies the view's scaling 
+//to get rescaled values. Files the view cannot describe are passed as the app helper's 
+//decoded buffer, already rescaled, with the helper as the view's owner: 
+static bool read_dicom_pixels
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    DicomSourceType sourceType, 
+    const std::function<bool(const VolumeView&)>& convert
+)
+{
+    std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMParser> dicomHandle(new DICOMPARSER_NAMESPACE::DICOMParser); 
+    std::shared_ptr<DICOMPARSER_NAMESPACE::DICOMAppHelper> dicomReader(new DICOMPARSER_NAMESPACE::DICOMAppHelper); 
+    DicomPixelReader pixelReader(dicomReader.get(), convert); 
+    DICOMPARSER_NAMESPACE::DICOMMemberCallback<DicomPixelReader> pixelDataCallback; 
+    pixelDataCallback.SetCallbackFunction(&pixelReader, &DicomPixelReader::PixelDataCallback); 
+
+    dicomHandle->ClearAllDICOMTagCallbacks(); 
+    dicomReader->RegisterCallbacks(dicomHandle.get()); 
+    dicomHandle->AddDICOMTagCallback(0x7FE0, 0x0010, DICOMPARSER_NAMESPACE::DICOMParser::VR_OB, &pixelDataCallback); 
+    dicomHandle->SetUseMappedFile(sourceType == DICOM_SOURCE_MAPPED); 
+
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    if(!dicomHandle->OpenFile(filename)){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+
+    //tags and pixel data are parsed in one pass, the conversion within it is recorded on its own: 
+    dicomHandle->ReadHeader(); 
+    timer.toc(); 
+    RecordDecode(std::max(timer.Duration() - pixelReader.convertMs, 0.0)); 
+    RecordBytesRead(FileBytes(filename)); 
+
+    DicomGeometry(
+        dicomReader.get(), 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+
+    if(pixelReader.isHandled){
+        return pixelReader.isConverted; 
+    }
+
+    void *dataBuffer = NULL; 
+    DICOMPARSER_NAMESPACE::DICOMParser::VRTypes dataType; 
+    unsigned long dataLength = 0;
+    dicomReader->GetImageData(dataBuffer, dataType, dataLength); 
+
+    VolumeView view; 
+    view.type = dicomReader->RescaledImageDataIsFloat() ? VOXEL_FLOAT32 : DicomStoredVoxelType(dicomReader.get()); 
+    if(dataBuffer == NULL || view.type == VOXEL_UNKNOWN || 
+        (dataType == DICOMPARSER_NAMESPACE::DICOMParser::VR_FL) != (view.type == VOXEL_FLOAT32)){
+        std::cout << "ERROR: The data type is not supported. " << std::endl; 
+        return false; 
+    }
+
+    view.dim[0] = dimX; view.dim[1] = dimY; view.dim[2] = dimZ; 
+    if(dataLength < view.NumberOfVoxels() * VoxelTypeSize(view.type)){
+        std::cout << "ERROR: Pixel data is shorter than the image dimension. " << std::endl; 
+        return false; 
+    }
+
+    SetPackedStrides(view); 
+    view.data = static_cast<const unsigned char*>(dataBuffer); 
+    view.owner = dicomReader; 
+    return convert(view); 
+}
+
+bool read_dicom
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    FloatBuffer& ImageBuff, 
+    DicomSourceType sourceType
 )
 {
-    
-    nifti_image* niiImage = new nifti_image;
-    niiImage = nifti_image_read(filename, true);
-
-    if(niiImage == NULL){
-        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
-        return false; 
-    }
-
-    //dimension: 
-    dimX = niiImage->nx; dimY = niiImage->ny; dimZ = niiImage->nz; 
+    return read_dicom_pixels(
+        filename, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ, 
+        sourceType, 
+        [&](const VolumeView& view){ return ConvertToFloat(view, ImageBuff, true); }); 
+}
 
-    //spacing: 
-    spacingX = niiImage->dx; spacingY = niiImage->dy; spacingZ = niiImage->dz; 
+bool read_dicom
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VolumeView& view, 
+    DicomSourceType sourceType
+)
+{
+    //the parser's buffer goes away with the parser: stored voxels are copied to a pooled buffer, 
+    //rescaled ones converted to float into it. The helper's decoded buffer is kept as it is: 
+    auto keepView = [&](const VolumeView& pixelView) -> bool{
+        view = pixelView; 
+        if(pixelView.owner){
+            return true; 
+        }
 
-    //origin: 
-    originX = niiImage->sto_xyz.m[0][3]; originY = niiImage->sto_xyz.m[1][3]; originZ = niiImage->sto_xyz.m[2][3]; 
+        bool isRescaled = (pixelView.slope != 1.0f || pixelView.intercept != 0.0f); 
+        if(isRescaled){
+            view.type = VOXEL_FLOAT32; 
+            view.byteSwapped = false; 
+            view.slope = 1.0f; 
+            view.intercept = 0.0f; 
+            view.bitsStored = 0; 
+        }
+        SetPackedStrides(view); 
+        std::shared_ptr<unsigned char> volume = AcquireBuffer(view.NumberOfVoxels() * VoxelTypeSize(view.type)); 
+        if(isRescaled){
+            if(!ConvertToFloat(pixelView, reinterpret_cast<float*>(volume.get()), true)){
+                view = VolumeView(); 
+                return false; 
+            }
+        }
+        else{
+            std::memcpy(volume.get(), pixelView.data, view.NumberOfVoxels() * VoxelTypeSize(view.type)); 
+        }
+        view.data = volume.get(); 
+        view.owner = volume; 
+        return true; 
+    }; 
+
+    view = VolumeView(); 
+    return read_dicom_pixels(
+        filename, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ, 
+        sourceType, keepView); 
+}
 
-    //ImageData: 
-    ImageBuff.resize(dimX * dimY * dimZ, 0.0f); 
+bool map_dicom
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VolumeView& view, 
+    DicomSourceType sourceType
+)
+{
 
-    switch (niiImage->datatype)
-    {
-    case DT_UINT8:
-        std::copy((uint8_t*)niiImage->data, (uint8_t*)niiImage->data + niiImage->nvox, ImageBuff.begin()); 
-        break;
+    std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMParser> dicomHandle(new DICOMPARSER_NAMESPACE::DICOMParser); 
+    std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMAppHelper> dicomReader(new DICOMPARSER_NAMESPACE::DICOMAppHelper); 
 
-    case DT_INT16:
-        std::copy((short*)niiImage->data, (short*)niiImage->data + niiImage->nvox, ImageBuff.begin()); 
-        break;
+    //no pixel data callback, the parser stops at the pixel data and records its offset: 
+    dicomHandle->ClearAllDICOMTagCallbacks(); 
+    dicomReader->RegisterCallbacks(dicomHandle.get()); 
+    dicomHandle->SetUseMappedFile(sourceType == DICOM_SOURCE_MAPPED); 
+    dicomHandle->SetStopBeforePixelData(true); 
 
-    case DT_UINT16:
-        std::copy((uint16_t*)niiImage->data, (uint16_t*)niiImage->data + niiImage->nvox, ImageBuff.begin()); 
-        break;
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    if(!dicomHandle->OpenFile(filename) || !dicomHandle->ReadHeader()){
+        return false; 
+    }
 
-    case DT_INT32:
-        std::copy((int*)niiImage->data, (int*)niiImage->data + niiImage->nvox, ImageBuff.begin()); 
-        break;
+    //encapsulated data, color images and rescaled values need decoding: 
+    long pixelOffset = dicomHandle->GetPixelDataOffset(); 
+    if(pixelOffset < 0 || dicomReader->GetNumberOfComponents() != 1 || 
+        dicomReader->GetRescaleSlope() != 1.0f || dicomReader->GetRescaleOffset() != 0.0f){
+        return false; 
+    }
 
-    case DT_FLOAT32: 
-        std::copy((float*)niiImage->data, (float*)niiImage->data + niiImage->nvox, ImageBuff.begin()); 
-        break; 
-    
-    default:
-        std::cout << "Data type cannot be recongnized! " << std::endl; 
-        break;
+    VoxelType voxelType = DicomStoredVoxelType(dicomReader.get()); 
+    if(voxelType == VOXEL_UNKNOWN){
+        return false; 
     }
 
-    delete niiImage; 
+    DicomGeometry(
+        dicomReader.get(), 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+
+    view = VolumeView(); 
+    view.type = voxelType; 
+    view.dim[0] = dimX; view.dim[1] = dimY; view.dim[2] = dimZ; 
+    size_t payloadLength = view.NumberOfVoxels() * VoxelTypeSize(voxelType); 
+    if(payloadLength > static_cast<size_t>(static_cast<unsigned int>(dicomHandle->GetPixelDataLength()))){
+        view = VolumeView(); 
+        return false; 
+    }
 
-    //correct the vertical convention: 
-    std::vector<float> ImageBuff_Correct(dimX * dimY * dimZ, 0.0f); 
-    for(int idxZ = 0; idxZ < dimZ; ++idxZ){
-        for(int idxY = 0; idxY < dimY; ++idxY){
-            std::copy(
-                ImageBuff.begin() + (dimX * dimY * idxZ + (dimX * dimY) - (idxY + 1) * dimX),  
-                ImageBuff.begin() + (dimX * dimY * idxZ + (dimX * dimY) - (idxY) * dimX), 
-                ImageBuff_Correct.begin() + (dimX * dimY * idxZ + idxY * dimX)
-            ); 
-        }
+    std::shared_ptr<Utilities::MappedFile> mappedFile(new Utilities::MappedFile); 
+    if(!mappedFile->Open(filename) || static_cast<size_t>(pixelOffset) + payloadLength > mappedFile->Size()){
+        view = VolumeView(); 
+        return false; 
     }
 
-    std::copy(ImageBuff_Correct.begin(), ImageBuff_Correct.end(), ImageBuff.begin()); 
+    SetPackedStrides(view); 
+    view.data = mappedFile->Data() + pixelOffset; 
+    view.byteSwapped = VoxelTypeSize(voxelType) > 1 && 
+        (dicomHandle->GetToggleByteSwapImageData() ^ dicomHandle->GetDICOMFile()->GetPlatformIsBigEndian()); 
+    view.bitsStored = dicomReader->GetBitsStored(); 
+    view.owner = mappedFile; 
 
+    timer.toc(); 
+    RecordHeader(timer.Duration()); 
+    RecordBytesRead(payloadLength); 
     return true; 
 }
 
-/* ------------------------------ IO routine for DICOM ---------------------------- */ 
-bool read_dicom
+bool read_dicom_header
 (   
     const char *filename, 
     int& dimX, int& dimY, int& dimZ, 
     float& spacingX, float& spacingY, float& spacingZ, 
     float& originX, float& originY, float& originZ, 
-    std::vector<float>& ImageBuff
+    VoxelType& voxelType, float direction[9], 
+    DicomSourceType sourceType
 )
 {
 
     std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMParser> dicomHandle(new DICOMPARSER_NAMESPACE::DICOMParser); 
     std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMAppHelper> dicomReader(new DICOMPARSER_NAMESPACE::DICOMAppHelper); 
 
+    //parsing ends at (7FE0,0010), the pixel data is never read: 
     dicomHandle->ClearAllDICOMTagCallbacks(); 
     dicomReader->RegisterCallbacks(dicomHandle.get()); 
-    dicomReader->RegisterPixelDataCallback(dicomHandle.get()); 
+    dicomHandle->SetUseMappedFile(sourceType == DICOM_SOURCE_MAPPED); 
+    dicomHandle->SetStopBeforePixelData(true); 
 
+    Utilities::MyTimer timer; 
+    timer.tic(); 
     bool isOpen = dicomHandle->OpenFile(filename); 
     if(!isOpen){
         std::cout << "File: " << filename << ", failed to open. " << std::endl; 
         return false; 
     }
 
-    dicomHandle->ReadHeader(); 
+    if(!dicomHandle->ReadHeader()){
+        std::cout << "File: " << filename << ", is not a DICOM file. " << std::endl; 
+        return false; 
+    }
 
-    spacingX = dicomReader->GetPixelSpacing()[0]; 
-    spacingY = dicomReader->GetPixelSpacing()[1]; 
-    spacingZ = dicomReader->GetPixelSpacing()[2]; 
+    DicomGeometry(
+        dicomReader.get(), 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+    DicomDirection(dicomReader.get(), direction); 
 
-    dimX = dicomReader->GetDimensions()[0]; 
-    dimY = dicomReader->GetDimensions()[0]; 
-    dimZ = dicomReader->GetSliceNumber(); 
+    //rescaled images are decoded to float: 
+    if(dicomReader->RescaledImageDataIsFloat()){
+        voxelType = VOXEL_FLOAT32; 
+    }
+    else{
+        voxelType = DicomStoredVoxelType(dicomReader.get()); 
+    }
 
-    originX = dicomReader->GetImagePositionPatient()[0]; 
-    originY = dicomReader->GetImagePositionPatient()[1]; 
-    originZ = dicomReader->GetImagePositionPatient()[2]; 
-    
-    void *dataBuffer = NULL; 
-    DICOMPARSER_NAMESPACE::DICOMParser::VRTypes dataType; 
-    unsigned long dataLength = 0;
-    dicomReader->GetImageData(dataBuffer, dataType, dataLength); 
+    timer.toc(); 
+    RecordHeader(timer.Duration()); 
+    return true; 
+}
 
-    ImageBuff.resize(dimX * dimY * dimZ, 0.0f); 
-    
-    switch (dataType)
-    {
-    case DICOMPARSER_NAMESPACE::DICOMParser::VR_OW: 
+bool read_dicom_region
+(   
+    const char *filename, 
+    const int start[3], const int size[3], 
+    FloatBuffer& ImageBuff, 
+    DicomSourceType sourceType
+)
+{
+
+    std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMParser> dicomHandle(new DICOMPARSER_NAMESPACE::DICOMParser); 
+    std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMAppHelper> dicomReader(new DICOMPARSER_NAMESPACE::DICOMAppHelper); 
+
+    dicomHandle->ClearAllDICOMTagCallbacks(); 
+    dicomReader->RegisterCallbacks(dicomHandle.get()); 
+    dicomHandle->SetUseMappedFile(sourceType == DICOM_SOURCE_MAPPED); 
+    dicomHandle->SetStopBeforePixelData(true); 
+
+    if(!dicomHandle->OpenFile(filename) || !dicomHandle->ReadHeader()){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+
+    int dim[3]; 
+    float spacing[3], origin[3]; 
+    DicomGeometry(
+        dicomReader.get(), 
+        dim[0], dim[1], dim[2], 
+        spacing[0], spacing[1], spacing[2], 
+        origin[0], origin[1], origin[2]); 
+    if(!RegionInside(dim, start, size)){
+        return false; 
+    }
+
+    //frames of plain stored values are read in place, anything that needs decoding 
+    //(encapsulated, color, rescaled) is cropped from the decoded file: 
+    VolumeView layout; 
+    layout.type = DicomStoredVoxelType(dicomReader.get()); 
+    layout.dim[0] = dim[0]; layout.dim[1] = dim[1]; layout.dim[2] = dim[2]; 
+    long pixelOffset = dicomHandle->GetPixelDataOffset(); 
+    if(pixelOffset < 0 || layout.type == VOXEL_UNKNOWN || dicomReader->GetNumberOfComponents() != 1 || 
+        dicomReader->GetRescaleSlope() != 1.0f || dicomReader->GetRescaleOffset() != 0.0f || 
+        layout.NumberOfVoxels() * VoxelTypeSize(layout.type) > 
+            static_cast<size_t>(static_cast<unsigned int>(dicomHandle->GetPixelDataLength()))){
+        return read_dicom_pixels(
+            filename, 
+            dim[0], dim[1], dim[2], 
+            spacing[0], spacing[1], spacing[2], 
+            origin[0], origin[1], origin[2], 
+            sourceType, 
+            [&](const VolumeView& view){ return ConvertToFloat(CropView(view, start, size), ImageBuff, true); }); 
+    }
+
+    SetPackedStrides(layout); 
+    layout.byteSwapped = VoxelTypeSize(layout.type) > 1 && 
+        (dicomHandle->GetToggleByteSwapImageData() ^ dicomHandle->GetDICOMFile()->GetPlatformIsBigEndian()); 
+    layout.bitsStored = dicomReader->GetBitsStored(); 
+
+    std::unique_ptr<FILE, int(*)(FILE*)> file(fopen(filename, "rb"), fclose); 
+    if(!file){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+    return ReadRawRegion(file.get(), pixelOffset, layout, start, size, ImageBuff); 
+}
+
+/* ------------------------------ DICOM directory scan ---------------------------- */ 
+DicomFileHeader::DicomFileHeader()
+{
+    dim[0] = 0; dim[1] = 0; dim[2] = 0; 
+    spacing[0] = 1.0f; spacing[1] = 1.0f; spacing[2] = 1.0f; 
+    imagePosition[0] = 0.0f; imagePosition[1] = 0.0f; imagePosition[2] = 0.0f; 
+    for(int idx = 0; idx < 6; ++idx){
+        orientation[idx] = (idx == 0 || idx == 4) ? 1.0f : 0.0f; 
+    }
+    voxelType = VOXEL_UNKNOWN; 
+    pixelDataOffset = -1; 
+}
+
+//text values are padded to an even length with spaces or NULs: 
+static std::string TrimmedTag(const char *value)
+{
+    std::string text(value); 
+    size_t end = text.find_last_not_of(" \0", std::string::npos, 2); 
+    return (end == std::string::npos) ? std::string() : text.substr(0, end + 1); 
+}
+
+bool read_dicom_file_header(const char *filename, DicomFileHeader& header, DicomSourceType sourceType)
+{
+    std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMParser> dicomHandle(new DICOMPARSER_NAMESPACE::DICOMParser); 
+    std::unique_ptr<DICOMPARSER_NAMESPACE::DICOMAppHelper> dicomReader(new DICOMPARSER_NAMESPACE::DICOMAppHelper); 
+
+    //no pixel data callback and the parse ends at (7FE0,0010), only the leading tags are read: 
+    dicomHandle->ClearAllDICOMTagCallbacks(); 
+    dicomReader->RegisterCallbacks(dicomHandle.get()); 
+    dicomHandle->SetUseMappedFile(sourceType == DICOM_SOURCE_MAPPED); 
+    dicomHandle->SetStopBeforePixelData(true); 
+
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    if(!dicomHandle->OpenFile(filename) || !dicomHandle->ReadHeader()){
+        return false; 
+    }
+
+    //the helper's getters copy into buffers of its own tag size: 
+    char text[512]; 
+    header = DicomFileHeader(); 
+    header.filePath = filename; 
+    dicomReader->GetPatientID(text); 
+    header.patientID = TrimmedTag(text); 
+    dicomReader->GetStudyID(text); 
+    header.studyID = TrimmedTag(text); 
+    dicomReader->GetModality(text); 
+    header.modality = TrimmedTag(text); 
+    header.seriesUID = TrimmedTag(dicomReader->GetSeriesUID().c_str()); 
+    header.seriesDescription = TrimmedTag(dicomReader->GetSeriesDescription().c_str()); 
+
+    header.dim[0] = dicomReader->GetDimensions()[0]; 
+    header.dim[1] = dicomReader->GetDimensions()[1]; 
+    header.dim[2] = std::max(dicomReader->GetSliceNumber(), 1); 
+    for(int idx = 0; idx < 3; ++idx){
+        header.spacing[idx] = dicomReader->GetPixelSpacing()[idx]; 
+        header.imagePosition[idx] = dicomReader->GetImagePositionPatient()[idx]; 
+    }
+    for(int idx = 0; idx < 6; ++idx){
+        header.orientation[idx] = dicomReader->GetImageOrientationPatient()[idx]; 
+    }
+    header.voxelType = dicomReader->RescaledImageDataIsFloat() ? VOXEL_FLOAT32 : DicomStoredVoxelType(dicomReader.get()); 
+    header.pixelDataOffset = dicomHandle->GetPixelDataOffset(); 
+
+    timer.toc(); 
+    RecordHeader(timer.Duration()); 
+    return true; 
+}
+
+bool scan_dicom_files
+(   
+    const std::vector<std::string>& filePaths, 
+    std::vector<DicomFileHeader>& headers, int numThreads, 
+    DicomSourceType sourceType
+)
+{
+    //every file on its own parser, the helper's series maps are not shared between threads. 
+    //Stats of the pool threads are gathered here and added to the caller's scope: 
+    std::vector<DicomFileHeader> parsed(filePaths.size()); 
+    std::vector<char> isDicom(filePaths.size(), 0); 
+    ReadStats scanStats; 
+    std::mutex statsMutex; 
+    RunParallel(static_cast<int>(filePaths.size()), PoolThreads(numThreads), [&](int item){
+        ReadStats fileStats; 
         {
-            int16_t* castedInt16Buffer = static_cast<int16_t*>(dataBuffer); 
-            std::copy(castedInt16Buffer, castedInt16Buffer + dataLength / 2, ImageBuff.begin()); 
+            ReadStatsScope statsScope(fileStats); 
+            isDicom[item] = read_dicom_file_header(filePaths[item].c_str(), parsed[item], sourceType) ? 1 : 0; 
         }
-        
-        break;
+        std::lock_guard<std::mutex> lock(statsMutex); 
+        scanStats.Add(fileStats); 
+    }); 
+    AddToCurrentReadStats(scanStats); 
+
+    headers.clear(); 
+    for(size_t idx = 0; idx < parsed.size(); ++idx){
+        if(isDicom[idx]){
+            headers.push_back(parsed[idx]); 
+        }
+    }
+    return true; 
+}
+
+bool scan_dicom_directory
+(   
+    const char *directory, 
+    std::vector<DicomFileHeader>& headers, 
+    bool recursive, int numThreads, 
+    DicomSourceType sourceType
+)
+{
+    std::vector<std::string> filePaths; 
+    if(!Utilities::ListDirectory(directory, filePaths, recursive)){
+        std::cout << "Directory: " << directory << ", failed to open. " << std::endl; 
+        return false; 
+    }
+    return scan_dicom_files(filePaths, headers, numThreads, sourceType); 
+}
+
+
+/* ------------------------------ IO routine for DICOM series ---------------------------- */ 
+DicomSeries::DicomSeries()
+{
+    dim[0] = 0; dim[1] = 0; dim[2] = 0; 
+    spacing[0] = 1.0f; spacing[1] = 1.0f; spacing[2] = 1.0f; 
+    origin[0] = 0.0f; origin[1] = 0.0f; origin[2] = 0.0f; 
+    for(int idx = 0; idx < 9; ++idx){
+        direction[idx] = (idx % 4 == 0) ? 1.0f : 0.0f; 
+    }
+    voxelType = VOXEL_UNKNOWN; 
+}
+
+//what the series scan needs from one file, parsed up to the pixel data: 
+bool scan_dicom_series
+(   
+    const std::vector<std::string>& filePaths, 
+    DicomSeries& series, 
+    const std::string& seriesUID, int numThreads, 
+    DicomSourceType sourceType
+)
+{
+    series = DicomSeries(); 
+
+    std::vector<DicomFileHeader> headers; 
+    scan_dicom_files(filePaths, headers, numThreads, sourceType); 
+
+    //single-frame slices grouped by SeriesInstanceUID, the largest group unless one is asked for: 
+    std::map<std::string, std::vector<int> > groups; 
+    for(size_t idx = 0; idx < headers.size(); ++idx){
+        if(headers[idx].dim[2] == 1){
+            groups[headers[idx].seriesUID].push_back(static_cast<int>(idx)); 
+        }
+    }
+
+    std::map<std::string, std::vector<int> >::iterator chosen = groups.end(); 
+    if(!seriesUID.empty()){
+        chosen = groups.find(seriesUID); 
+    }
+    else{
+        for(std::map<std::string, std::vector<int> >::iterator group = groups.begin(); group != groups.end(); ++group){
+            if(chosen == groups.end() || group->second.size() > chosen->second.size()){
+                chosen = group; 
+            }
+        }
+    }
+    if(chosen == groups.end()){
+        std::cout << "ERROR: No DICOM series " << seriesUID << " was found. " << std::endl; 
+        return false; 
+    }
+
+    //the first slice defines size, type and orientation of the stack: 
+    std::vector<int>& members = chosen->second; 
+    const DicomFileHeader& reference = headers[members[0]]; 
+    float direction[9]; 
+    OrientationDirection(reference.orientation, direction); 
+
+    //image position along the slice normal: 
+    std::vector<float> positions(headers.size(), 0.0f); 
+    for(size_t idx = 0; idx < members.size(); ++idx){
+        const DicomFileHeader& slice = headers[members[idx]]; 
+        if(slice.dim[0] != reference.dim[0] || slice.dim[1] != reference.dim[1]){
+            std::cout << "ERROR: Slices of DICOM series " << chosen->first << " differ in size. " << std::endl; 
+            return false; 
+        }
+        positions[members[idx]] = 
+            slice.imagePosition[0] * direction[2] + 
+            slice.imagePosition[1] * direction[5] + 
+            slice.imagePosition[2] * direction[8]; 
+    }
+
+    //ascending along the normal, the file name decides between equal positions: 
+    std::sort(members.begin(), members.end(), [&](int lhs, int rhs){
+        if(positions[lhs] != positions[rhs]){
+            return positions[lhs] < positions[rhs]; 
+        }
+        return headers[lhs].filePath < headers[rhs].filePath; 
+    }); 
+
+    const DicomFileHeader& first = headers[members.front()]; 
+    float firstPosition = positions[members.front()]; 
+    float lastPosition = positions[members.back()]; 
+    series.seriesUID = chosen->first; 
+    series.dim[0] = reference.dim[0]; 
+    series.dim[1] = reference.dim[1]; 
+    series.dim[2] = static_cast<int>(members.size()); 
+    series.spacing[0] = reference.spacing[0]; 
+    series.spacing[1] = reference.spacing[1]; 
+    //mean slice distance, the slice thickness for a single slice or coincident positions: 
+    series.spacing[2] = (members.size() > 1 && lastPosition > firstPosition) ? 
+        (lastPosition - firstPosition) / (members.size() - 1) : reference.spacing[2]; 
+    for(int idx = 0; idx < 3; ++idx){
+        series.origin[idx] = first.imagePosition[idx]; 
+    }
+    for(int idx = 0; idx < 9; ++idx){
+        series.direction[idx] = direction[idx]; 
+    }
+
+    //one rescaled slice makes the volume float: 
+    series.voxelType = reference.voxelType; 
+    for(size_t idx = 0; idx < members.size(); ++idx){
+        series.filePaths.push_back(headers[members[idx]].filePath); 
+        if(headers[members[idx]].voxelType != series.voxelType){
+            series.voxelType = VOXEL_FLOAT32; 
+        }
+    }
+    return true; 
+}
+
+bool scan_dicom_series
+(   
+    const char *directory, 
+    DicomSeries& series, 
+    const std::string& seriesUID, int numThreads, 
+    DicomSourceType sourceType
+)
+{
+    std::vector<std::string> filePaths; 
+    if(!Utilities::ListDirectory(directory, filePaths)){
+        std::cout << "Directory: " << directory << ", failed to open. " << std::endl; 
+        return false; 
+    }
+    return scan_dicom_series(filePaths, series, seriesUID, numThreads, sourceType); 
+}
+
+bool read_dicom_series
+(   
+    const DicomSeries& series, float* output, int numThreads, 
+    DicomSourceType sourceType
+)
+{
+    if(output == NULL || series.filePaths.empty()){
+        return false; 
+    }
 
-    case DICOMPARSER_NAMESPACE::DICOMParser::VR_FL: 
+    //each slice is mapped when its pixel data allows, decoded otherwise, 
+    //and converted by the thread that read it into its own z offset: 
+    const size_t sliceVoxels = static_cast<size_t>(series.dim[0]) * series.dim[1]; 
+    std::atomic<int> numFailed(0); 
+    ReadStats sliceStats; 
+    std::mutex statsMutex; 
+    RunParallel(static_cast<int>(series.filePaths.size()), PoolThreads(numThreads), [&](int slice){
+        const char *filename = series.filePaths[slice].c_str(); 
+        ReadStats stats; 
         {
-            float* castedFPBuffer = static_cast<float*>(dataBuffer); 
-            std::copy(castedFPBuffer, castedFPBuffer + dataLength / 4, ImageBuff.begin()); 
+            ReadStatsScope statsScope(stats); 
+            int dimX, dimY, dimZ; 
+            float spacingX, spacingY, spacingZ; 
+            float originX, originY, originZ; 
+            auto convertSlice = [&](const VolumeView& view) -> bool{
+                if(view.dim[0] != series.dim[0] || view.dim[1] != series.dim[1] || view.NumberOfVoxels() < sliceVoxels){
+                    std::cout << "File: " << filename << ", slice size differs from the series. " << std::endl; 
+                    return false; 
+                }
+                VolumeView sliceView = view; 
+                sliceView.dim[2] = 1; 
+                return ConvertToFloat(sliceView, output + slice * sliceVoxels, true, 1); 
+            }; 
+            VolumeView view; 
+            bool isRead = map_dicom(filename, dimX, dimY, dimZ, spacingX, spacingY, spacingZ, originX, originY, originZ, view, sourceType) ? 
+                convertSlice(view) : 
+                read_dicom_pixels(filename, dimX, dimY, dimZ, spacingX, spacingY, spacingZ, originX, originY, originZ, sourceType, convertSlice); 
+            if(!isRead){
+                ++numFailed; 
+            }
         }
-        
-        break;
+        std::lock_guard<std::mutex> lock(statsMutex); 
+        sliceStats.Add(stats); 
+    }); 
+    AddToCurrentReadStats(sliceStats); 
+
+    return numFailed == 0; 
+}
+
+bool read_nrrd
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    FloatBuffer& ImageBuff
+)
+{
+    VolumeView view; 
+    if(!read_nrrd(
+        filename, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ, 
+        view)){
+        return false; 
+    }
+
+    //parse raw data: 
+    return ConvertToFloat(view, ImageBuff); 
+}
+
+bool read_nrrd
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VolumeView& view
+)
+{
+    Nrrd *nrrdReader = nrrdNew(); 
+    NrrdIoState *nrrdIO = nrrdIoStateNew(); 
     
-    default:
-        break;
+    //read file, header and data are parsed in one pass, timed as decoding: 
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    int stat = nrrdLoad(nrrdReader, filename, nrrdIO); 
+    bool isEncoded = (nrrdIO->encoding != nrrdEncodingRaw); 
+    nrrdIoStateNix(nrrdIO); 
+    if(stat != 0){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        nrrdNuke(nrrdReader); 
+        return false; 
+    }
+    timer.toc(); 
+    double decodeMs = timer.Duration(); 
+    RecordDecode(decodeMs); 
+    RecordBytesRead(FileBytes(filename)); 
+    if(isEncoded){
+        RecordInflate(nrrdElementNumber(nrrdReader) * nrrdElementSize(nrrdReader), decodeMs); 
+    }
+
+    VoxelType voxelType = NrrdVoxelType(nrrdReader->type); 
+    if(voxelType == VOXEL_UNKNOWN){
+        std::cout << "ERROR: The data type is not supported. " << std::endl; 
+        nrrdNuke(nrrdReader); 
+        return false; 
+    }
+
+    //the view owns the nrrd, data is released with the last reference: 
+    std::shared_ptr<Nrrd> nrrdOwner(nrrdReader, nrrdNuke); 
+
+    NrrdGeometry(
+        nrrdReader, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+
+    //nrrdLoad already swapped the data to native order: 
+    view = VolumeView(); 
+    view.type = voxelType; 
+    view.dim[0] = dimX; view.dim[1] = dimY; view.dim[2] = dimZ; 
+    SetPackedStrides(view); 
+    view.data = static_cast<const unsigned char*>(nrrdReader->data); 
+    view.owner = nrrdOwner; 
+
+    return true; 
+}
+
+bool map_nrrd
+(   
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VolumeView& view
+)
+{
+    Nrrd *nrrdReader = nrrdNew(); 
+    NrrdIoState *nrrdIO = nrrdIoStateNew(); 
+
+    //parse the header and stop at the first data byte: 
+    nrrdIoStateSet(nrrdIO, nrrdIoStateSkipData, AIR_TRUE); 
+    nrrdIoStateSet(nrrdIO, nrrdIoStateKeepNrrdDataFileOpen, AIR_TRUE); 
+
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    bool mapped = false; 
+    if(nrrdLoad(nrrdReader, filename, nrrdIO) == 0 && 
+        nrrdIO->format == nrrdFormatNRRD && 
+        nrrdIO->encoding == nrrdEncodingRaw && 
+        nrrdIO->dataFile != NULL){
+
+        VoxelType voxelType = NrrdVoxelType(nrrdReader->type); 
+        long payloadOffset = ftell(nrrdIO->dataFile); 
+
+        std::shared_ptr<Utilities::MappedFile> mappedFile(new Utilities::MappedFile); 
+        if(voxelType != VOXEL_UNKNOWN && payloadOffset >= 0 && mappedFile->Open(fileno(nrrdIO->dataFile))){
+            NrrdGeometry(
+                nrrdReader, 
+                dimX, dimY, dimZ, 
+                spacingX, spacingY, spacingZ, 
+                originX, originY, originZ); 
+
+            view = VolumeView(); 
+            view.type = voxelType; 
+            view.dim[0] = dimX; view.dim[1] = dimY; view.dim[2] = dimZ; 
+            SetPackedStrides(view); 
+
+            if(static_cast<size_t>(payloadOffset) + view.NumberOfVoxels() * VoxelTypeSize(voxelType) <= mappedFile->Size()){
+                view.data = mappedFile->Data() + payloadOffset; 
+                view.byteSwapped = (VoxelTypeSize(voxelType) > 1 && 
+                    nrrdIO->endian != airEndianUnknown && nrrdIO->endian != airMyEndian()); 
+                view.owner = mappedFile; 
+                mapped = true; 
+                RecordBytesRead(view.NumberOfVoxels() * VoxelTypeSize(voxelType)); 
+            }
+            else{
+                view = VolumeView(); 
+            }
+        }
+    }
+
+    if(nrrdIO->dataFile != NULL){
+        nrrdIO->dataFile = airFclose(nrrdIO->dataFile); 
     }
-    
+    nrrdIoStateNix(nrrdIO); 
+    nrrdNuke(nrrdReader); 
+
+    timer.toc(); 
+    if(mapped){
+        RecordHeader(timer.Duration()); 
+    }
+    return mapped; 
 }
 
-bool read_nrrd
+bool read_nrrd_header
 (   
     const char *filename, 
     int& dimX, int& dimY, int& dimZ, 
     float& spacingX, float& spacingY, float& spacingZ, 
     float& originX, float& originY, float& originZ, 
-    std::vector<float>& ImageBuff
+    VoxelType& voxelType, float direction[9]
 )
 {
     Nrrd *nrrdReader = nrrdNew(); 
-    
-    //read file: 
-    int stat = nrrdLoad(nrrdReader, filename, NULL); 
+    NrrdIoState *nrrdIO = nrrdIoStateNew(); 
+
+    //header only, the data file is neither read nor decompressed: 
+    nrrdIoStateSet(nrrdIO, nrrdIoStateSkipData, AIR_TRUE); 
+
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+    int stat = nrrdLoad(nrrdReader, filename, nrrdIO); 
+    nrrdIoStateNix(nrrdIO); 
     if(stat != 0){
         std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        nrrdNuke(nrrdReader); 
         return false; 
     }
 
-    dimX = static_cast<int>(nrrdReader->axis[0].size); 
-    dimY = static_cast<int>(nrrdReader->axis[1].size); 
-    dimZ = static_cast<int>(nrrdReader->axis[2].size); 
-
-    int vectorIncrement=0;
-    if(nrrdReader->axis[0].kind==nrrdKindVector){
-        vectorIncrement=1;
-    }
-
-    double spaceDir[NRRD_SPACE_DIM_MAX], spacing;
-
-    nrrdSpacingCalculate(nrrdReader, vectorIncrement, &spacing, spaceDir); 
-    spacingX = spacing; 
+    NrrdGeometry(
+        nrrdReader, 
+        dimX, dimY, dimZ, 
+        spacingX, spacingY, spacingZ, 
+        originX, originY, originZ); 
+    NrrdDirection(nrrdReader, direction); 
+    voxelType = NrrdVoxelType(nrrdReader->type); 
 
-    nrrdSpacingCalculate(nrrdReader, 1 + vectorIncrement, &spacing, spaceDir); 
-    spacingY = spacing; 
+    nrrdNuke(nrrdReader); 
+    timer.toc(); 
+    RecordHeader(timer.Duration()); 
+    return true; 
+}
+bool read_nrrd_region
+(   
+    const char *filename, 
+    const int start[3], const int size[3], 
+    FloatBuffer& ImageBuff
+)
+{
+    Nrrd *nrrdReader = nrrdNew(); 
+    NrrdIoState *nrrdIO = nrrdIoStateNew(); 
 
-    nrrdSpacingCalculate(nrrdReader, 2 + vectorIncrement, &spacing, spaceDir); 
-    spacingZ = spacing; 
+    //parse the header and stop at the first data byte: 
+    nrrdIoStateSet(nrrdIO, nrrdIoStateSkipData, AIR_TRUE); 
+    nrrdIoStateSet(nrrdIO, nrrdIoStateKeepNrrdDataFileOpen, AIR_TRUE); 
 
-    originX = static_cast<float>(nrrdReader->spaceOrigin[0]); 
-    originY = static_cast<float>(nrrdReader->spaceOrigin[1]); 
-    originZ = static_cast<float>(nrrdReader->spaceOrigin[2]); 
+    if(nrrdLoad(nrrdReader, filename, nrrdIO) != 0){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        if(nrrdIO->dataFile != NULL){
+            nrrdIO->dataFile = airFclose(nrrdIO->dataFile); 
+        }
+        nrrdIoStateNix(nrrdIO); 
+        nrrdNuke(nrrdReader); 
+        return false; 
+    }
 
-    //parse raw data: 
-    ImageBuff.resize(dimX * dimY * dimZ, 0.0f); 
-    switch(nrrdReader->type)
-    {
-        case nrrdTypeUChar:
-            std::copy((u_char*)nrrdReader->data, (u_char*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        case nrrdTypeChar:
-            std::copy((char*)nrrdReader->data, (char*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        case nrrdTypeUShort:
-            std::copy((u_short*)nrrdReader->data, (u_short*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        case nrrdTypeShort:
-            std::copy((short*)nrrdReader->data, (short*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        case nrrdTypeUInt:
-            std::copy((uint*)nrrdReader->data, (uint*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        case nrrdTypeInt:
-            std::copy((int*)nrrdReader->data, (int*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        case nrrdTypeFloat:
-            std::copy((float*)nrrdReader->data, (float*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        case nrrdTypeDouble:
-            std::copy((double*)nrrdReader->data, (double*)nrrdReader->data + (dimX * dimY * dimZ), ImageBuff.begin()); 
-            break;
-        default:
-            std::cout << "ERROR: The data type is not supported. " << std::endl; 
-            return false; 
+    int dim[3]; 
+    float spacing[3], origin[3]; 
+    NrrdGeometry(
+        nrrdReader, 
+        dim[0], dim[1], dim[2], 
+        spacing[0], spacing[1], spacing[2], 
+        origin[0], origin[1], origin[2]); 
+
+    VolumeView layout; 
+    layout.type = NrrdVoxelType(nrrdReader->type); 
+    layout.dim[0] = dim[0]; layout.dim[1] = dim[1]; layout.dim[2] = dim[2]; 
+    SetPackedStrides(layout); 
+    layout.byteSwapped = (VoxelTypeSize(layout.type) > 1 && 
+        nrrdIO->endian != airEndianUnknown && nrrdIO->endian != airMyEndian()); 
+
+    bool isRaw = (nrrdIO->format == nrrdFormatNRRD && 
+        nrrdIO->encoding == nrrdEncodingRaw && 
+        nrrdIO->dataFile != NULL); 
+
+    bool isRead = false; 
+    if(layout.type == VOXEL_UNKNOWN){
+        std::cout << "ERROR: The data type is not supported. " << std::endl; 
+    }
+    else if(RegionInside(dim, start, size)){
+        if(isRaw){
+            isRead = ReadRawRegion(nrrdIO->dataFile, ftell(nrrdIO->dataFile), layout, start, size, ImageBuff); 
+        }
+        else{
+            //compressed encodings cannot seek, the region is cropped from the decoded volume: 
+            VolumeView view; 
+            isRead = read_nrrd(
+                filename, 
+                dim[0], dim[1], dim[2], 
+                spacing[0], spacing[1], spacing[2], 
+                origin[0], origin[1], origin[2], 
+                view); 
+            if(isRead){
+                isRead = ConvertToFloat(CropView(view, start, size), ImageBuff); 
+            }
+        }
     }
 
+    if(nrrdIO->dataFile != NULL){
+        nrrdIO->dataFile = airFclose(nrrdIO->dataFile); 
+    }
+    nrrdIoStateNix(nrrdIO); 
     nrrdNuke(nrrdReader); 
-    return true; 
-}
 
+    return isRead; 
+}
 }
 
 MedicalImageIO::MedicalImageIO(){
     dimension[0] = 0; dimension[1] = 0; dimension[2] = 0; 
+    numberOfVolumes = 1; 
     spacing[0] = 0.0f; spacing[1] = 0.0f; spacing[2] = 0.0f; 
     origin[0] = 0.0f; origin[1] = 0.0f; origin[2] = 0.0f; 
 
@@ -258,10 +1850,23 @@ MedicalImageIO::MedicalImageIO(){
     isParsed = false; 
     isBufferAvailable = false; 
     isHeaderAvailable = false; 
+    isViewMapped = false; 
+    useMemoryMapping = false; 
+    useIntensityScaling = false; 
+    numberOfThreads = 0; 
+    dicomSourceType = MedImageParser::DICOM_SOURCE_MAPPED; 
+    isRecordingStats = false; 
+    isDicomSeries = false; 
+
+    voxelType = MedImageParser::VOXEL_UNKNOWN; 
+    for(int idx = 0; idx < 9; ++idx){
+        direction[idx] = (idx % 4 == 0) ? 1.0f : 0.0f; 
+    }
 }
 
 MedicalImageIO::MedicalImageIO(std::string _filePath){
     dimension[0] = 0; dimension[1] = 0; dimension[2] = 0; 
+    numberOfVolumes = 1; 
     spacing[0] = 0.0f; spacing[1] = 0.0f; spacing[2] = 0.0f; 
     origin[0] = 0.0f; origin[1] = 0.0f; origin[2] = 0.0f; 
 
@@ -276,10 +1881,23 @@ MedicalImageIO::MedicalImageIO(std::string _filePath){
     isParsed = false; 
     isBufferAvailable = false; 
     isHeaderAvailable = false; 
+    isViewMapped = false; 
+    useMemoryMapping = false; 
+    useIntensityScaling = false; 
+    numberOfThreads = 0; 
+    dicomSourceType = MedImageParser::DICOM_SOURCE_MAPPED; 
+    isRecordingStats = false; 
+    isDicomSeries = Utilities::IsDirectory(filePath); 
+
+    voxelType = MedImageParser::VOXEL_UNKNOWN; 
+    for(int idx = 0; idx < 9; ++idx){
+        direction[idx] = (idx % 4 == 0) ? 1.0f : 0.0f; 
+    }
 }
 
 MedicalImageIO::MedicalImageIO(const char *_filePath){
     dimension[0] = 0; dimension[1] = 0; dimension[2] = 0; 
+    numberOfVolumes = 1; 
     spacing[0] = 0.0f; spacing[1] = 0.0f; spacing[2] = 0.0f; 
     origin[0] = 0.0f; origin[1] = 0.0f; origin[2] = 0.0f; 
 
@@ -294,9 +1912,55 @@ MedicalImageIO::MedicalImageIO(const char *_filePath){
     isParsed = false; 
     isBufferAvailable = false; 
     isHeaderAvailable = false; 
+    isViewMapped = false; 
+    useMemoryMapping = false; 
+    useIntensityScaling = false; 
+    numberOfThreads = 0; 
+    dicomSourceType = MedImageParser::DICOM_SOURCE_MAPPED; 
+    isRecordingStats = false; 
+    isDicomSeries = Utilities::IsDirectory(filePath); 
+
+    voxelType = MedImageParser::VOXEL_UNKNOWN; 
+    for(int idx = 0; idx < 9; ++idx){
+        direction[idx] = (idx % 4 == 0) ? 1.0f : 0.0f; 
+    }
 }
 
+//per-object read statistics, the outermost read call resets and times them: 
+class ReadStatsRecorder{
+public:
+    ReadStatsRecorder(MedImageParser::ReadStats& _stats, bool& _isRecording) : isRecording(_isRecording){
+        isOutermost = !isRecording; 
+        if(isOutermost){
+            _stats = MedImageParser::ReadStats(); 
+            isRecording = true; 
+            timer.tic(); 
+        }
+        scope.reset(new MedImageParser::ReadStatsScope(_stats)); 
+    }
+    ~ReadStatsRecorder(){
+        if(isOutermost){
+            timer.toc(); 
+            MedImageParser::RecordRead(timer.Duration()); 
+            isRecording = false; 
+        }
+    }
+
+private:
+    ReadStatsRecorder(const ReadStatsRecorder&); 
+    ReadStatsRecorder& operator=(const ReadStatsRecorder&); 
+
+    std::unique_ptr<MedImageParser::ReadStatsScope> scope; 
+    Utilities::MyTimer timer; 
+    bool& isRecording; 
+    bool isOutermost; 
+}; 
+
 bool MedicalImageIO::ReadableCheck(){
+    if(isDicomSeries){
+        isReadable = true; 
+        return true; 
+    }
 
     if(std::find(readableExtensions.begin(), readableExtensions.end(), fileExtension) == readableExtensions.end()){
         std::cout << "File extension: " << fileExtension << " cannot be read. " << std::endl; 
@@ -308,6 +1972,22 @@ bool MedicalImageIO::ReadableCheck(){
     return true; 
 }
 
+void MedicalImageIO::SetMemoryMapping(bool enable){
+    useMemoryMapping = enable; 
+}
+
+void MedicalImageIO::SetIntensityScaling(bool enable){
+    useIntensityScaling = enable; 
+}
+
+void MedicalImageIO::SetNumberOfThreads(int numThreads){
+    numberOfThreads = numThreads; 
+}
+
+void MedicalImageIO::SetDicomSource(MedImageParser::DicomSourceType sourceType){
+    dicomSourceType = sourceType; 
+}
+
 bool MedicalImageIO::BufferAvailable(){
     return isBufferAvailable; 
 }
@@ -317,55 +1997,545 @@ bool MedicalImageIO::HeaderAvailable(){
 }
 
 bool MedicalImageIO::Read(){
-    if(fileExtension == ".nii" || fileExtension == ".nii.gz"){
-        std::cout << "NIfTI file was parsed. " << std::endl; 
-        isParsed = MedImageParser::read_nii( 
+    ReadStatsRecorder recorder(readStats, isRecordingStats); 
+    nativeView = MedImageParser::VolumeView(); 
+
+    //slices are decoded straight into the float buffer, resize() leaves it for them to write: 
+    if(isDicomSeries){
+        MedImageParser::DicomSeries series; 
+        isParsed = ReadSeriesHeader(series); 
+        if(isParsed){
+            dataBuffer.resize(static_cast<size_t>(dimension[0]) * dimension[1] * dimension[2]); 
+            isParsed = MedImageParser::read_dicom_series(series, dataBuffer.data(), numberOfThreads, dicomSourceType); 
+        }
+        if(!isParsed){
+            dataBuffer.clear(); 
+        }
+        isBufferAvailable = isParsed; 
+        return isParsed; 
+    }
+
+    //volumes decoded before, by this or another process: 
+    if(ReadCached()){
+        isParsed = MaterializeBuffer(); 
+        return isParsed; 
+    }
+
+    //DICOM pixel data is converted while it is parsed, others decode to the native view, 
+    //then one (parallel) conversion pass: 
+    if(fileExtension == ".dcm"){
+        dataBuffer.clear(); 
+        isParsed = ReadDicom([this](const MedImageParser::VolumeView& view){ 
+            return MedImageParser::ConvertToFloat(view, dataBuffer, true, numberOfThreads); 
+        }); 
+        if(!isParsed){
+            dataBuffer.clear(); 
+        }
+        isBufferAvailable = isParsed; 
+    }
+    else if(ReadNative()){
+        isParsed = MaterializeBuffer(); 
+    }
+    if(isParsed){
+        StoreCached(dataBuffer.data()); 
+    }
+
+    //only mapped views are kept, they cost no memory of their own. A decoder fallback 
+    //of a mapped read leaves a pooled buffer, which goes back to the pool: 
+    if(!isViewMapped){
+        nativeView = MedImageParser::VolumeView(); 
+    }
+    return isParsed; 
+}
+
+bool MedicalImageIO::ReadHeader(){
+    ReadStatsRecorder recorder(readStats, isRecordingStats); 
+    bool isRead = false; 
+
+    if(isDicomSeries){
+        MedImageParser::DicomSeries series; 
+        isRead = ReadSeriesHeader(series); 
+    }
+    else if(fileExtension == ".nii" || fileExtension == ".nii.gz"){
+        isRead = MedImageParser::read_nii_header( 
+            filePath.c_str(), 
+            dimension[0], dimension[1], dimension[2], 
+            spacing[0], spacing[1], spacing[2], 
+            origin[0], origin[1], origin[2], 
+            voxelType, direction, numberOfVolumes); 
+    }
+    else if(fileExtension == ".dcm"){
+        numberOfVolumes = 1; 
+        isRead = MedImageParser::read_dicom_header( 
             filePath.c_str(), 
             dimension[0], dimension[1], dimension[2], 
             spacing[0], spacing[1], spacing[2], 
             origin[0], origin[1], origin[2], 
-            dataBuffer); 
+            voxelType, direction, dicomSourceType); 
+    }
+    else if(fileExtension == ".nrrd"){
+        numberOfVolumes = 1; 
+        isRead = MedImageParser::read_nrrd_header( 
+            filePath.c_str(), 
+            dimension[0], dimension[1], dimension[2], 
+            spacing[0], spacing[1], spacing[2], 
+            origin[0], origin[1], origin[2], 
+            voxelType, direction); 
+    }
+    else{
+        std::cout << fileName << " was not supported. " << std::endl; 
+    }
+
+    isHeaderAvailable = isRead; 
+    return isRead; 
+}
 
-        isBufferAvailable = true;
-        isHeaderAvailable = true; 
+bool MedicalImageIO::ReadNative(){
+    ReadStatsRecorder recorder(readStats, isRecordingStats); 
+    dataBuffer.clear(); 
+    isViewMapped = false; 
+
+    if(isDicomSeries){
+        std::cout << "Dicom series was parsed. " << std::endl; 
+        MedImageParser::DicomSeries series; 
+        isParsed = ReadSeriesHeader(series); 
+        if(isParsed){
+            //slices differ in rescaling, the stack is native float: 
+            nativeView = MedImageParser::VolumeView(); 
+            nativeView.type = MedImageParser::VOXEL_FLOAT32; 
+            nativeView.dim[0] = dimension[0]; nativeView.dim[1] = dimension[1]; nativeView.dim[2] = dimension[2]; 
+            MedImageParser::SetPackedStrides(nativeView); 
+            std::shared_ptr<unsigned char> volume = MedImageParser::AcquireBuffer(nativeView.NumberOfVoxels() * sizeof(float)); 
+            isParsed = MedImageParser::read_dicom_series(series, reinterpret_cast<float*>(volume.get()), numberOfThreads, dicomSourceType); 
+            nativeView.data = volume.get(); 
+            nativeView.owner = volume; 
+        }
+        if(!isParsed){
+            nativeView = MedImageParser::VolumeView(); 
+        }
+    }
+    else if(fileExtension == ".nii" || fileExtension == ".nii.gz"){
+        std::cout << "NIfTI file was parsed. " << std::endl; 
+        isParsed = useMemoryMapping && MedImageParser::map_nii( 
+            filePath.c_str(), 
+            dimension[0], dimension[1], dimension[2], 
+            spacing[0], spacing[1], spacing[2], 
+            origin[0], origin[1], origin[2], 
+            nativeView); 
+        isViewMapped = isParsed; 
+        if(!isParsed){
+            isParsed = MedImageParser::read_nii( 
+                filePath.c_str(), 
+                dimension[0], dimension[1], dimension[2], 
+                spacing[0], spacing[1], spacing[2], 
+                origin[0], origin[1], origin[2], 
+                nativeView); 
+        }
     }
     else if(fileExtension == ".dcm"){
         std::cout << "Dicom file was parsed. " << std::endl; 
-        isParsed = MedImageParser::read_dicom( 
+        isParsed = useMemoryMapping && MedImageParser::map_dicom( 
             filePath.c_str(), 
             dimension[0], dimension[1], dimension[2], 
             spacing[0], spacing[1], spacing[2], 
             origin[0], origin[1], origin[2], 
-            dataBuffer);  
-
-        isBufferAvailable = true;
-        isHeaderAvailable = true; 
+            nativeView, dicomSourceType); 
+        isViewMapped = isParsed; 
+        if(!isParsed){
+            isParsed = MedImageParser::read_dicom( 
+                filePath.c_str(), 
+                dimension[0], dimension[1], dimension[2], 
+                spacing[0], spacing[1], spacing[2], 
+                origin[0], origin[1], origin[2], 
+                nativeView, dicomSourceType); 
+        }
     }
     else if(fileExtension == ".nrrd"){
         std::cout << "Nrrd file was parsed. " << std::endl; 
-        isParsed = MedImageParser::read_nrrd( 
+        isParsed = useMemoryMapping && MedImageParser::map_nrrd( 
             filePath.c_str(), 
             dimension[0], dimension[1], dimension[2], 
             spacing[0], spacing[1], spacing[2], 
             origin[0], origin[1], origin[2], 
-            dataBuffer); 
-        
-        isBufferAvailable = true; 
-        isHeaderAvailable = true; 
+            nativeView); 
+        isViewMapped = isParsed; 
+        if(!isParsed){
+            isParsed = MedImageParser::read_nrrd( 
+                filePath.c_str(), 
+                dimension[0], dimension[1], dimension[2], 
+                spacing[0], spacing[1], spacing[2], 
+                origin[0], origin[1], origin[2], 
+                nativeView); 
+        }
     }
     else{
         std::cout << fileName << " was not supported. " << std::endl; 
         isParsed = false; 
     }
+
+    numberOfVolumes = isParsed ? nativeView.dim[3] : 1; 
+
+    //the float buffer is produced from the view on first access: 
+    isBufferAvailable = isParsed; 
+    isHeaderAvailable = isParsed; 
+    return isParsed; 
+}
+
+bool MedicalImageIO::Read(float* output, size_t numVoxels){
+    if(output == NULL){
+        return false; 
+    }
+    ReadStatsRecorder recorder(readStats, isRecordingStats); 
+
+    if(isDicomSeries){
+        MedImageParser::DicomSeries series; 
+        isParsed = ReadSeriesHeader(series); 
+        size_t numSeriesVoxels = static_cast<size_t>(dimension[0]) * dimension[1] * dimension[2]; 
+        if(isParsed && numVoxels < numSeriesVoxels){
+            std::cout << "ERROR: Output buffer holds " << numVoxels << " voxels, " 
+                << numSeriesVoxels << " are needed. " << std::endl; 
+            isParsed = false; 
+        }
+        isParsed = isParsed && MedImageParser::read_dicom_series(series, output, numberOfThreads, dicomSourceType); 
+        isBufferAvailable = false; 
+        return isParsed; 
+    }
+
+    bool isCached = ReadCached(); 
+    if(!isCached && fileExtension == ".dcm"){
+        isParsed = ReadDicom([&](const MedImageParser::VolumeView& view) -> bool{ 
+            if(numVoxels < view.NumberOfVoxels()){
+                std::cout << "ERROR: Output buffer holds " << numVoxels << " voxels, " 
+                    << view.NumberOfVoxels() << " are needed. " << std::endl; 
+                return false; 
+            }
+            return MedImageParser::ConvertToFloat(view, output, true, numberOfThreads); 
+        }); 
+        if(isParsed){
+            StoreCached(output); 
+        }
+
+        nativeView = MedImageParser::VolumeView(); 
+        isBufferAvailable = false; 
+        return isParsed; 
+    }
+    if(!isCached && !ReadNative()){
+        return false; 
+    }
+
+    if(numVoxels < nativeView.NumberOfVoxels()){
+        std::cout << "ERROR: Output buffer holds " << numVoxels << " voxels, " 
+            << nativeView.NumberOfVoxels() << " are needed. " << std::endl; 
+        isParsed = false; 
+    }
+    else{
+        isParsed = MedImageParser::ConvertToFloat(nativeView, output, useIntensityScaling, numberOfThreads); 
+        if(isParsed && !isCached){
+            StoreCached(output); 
+        }
+    }
+
+    //the payload goes back to the pool, only the header is kept: 
+    nativeView = MedImageParser::VolumeView(); 
+    isBufferAvailable = false; 
+    return isParsed; 
+}
+
+bool MedicalImageIO::ReadRegion(const int start[3], const int size[3], MedImageParser::FloatBuffer& region){
+    ReadStatsRecorder recorder(readStats, isRecordingStats); 
+    bool isRead = false; 
+
+    if(isDicomSeries){
+        std::cout << "Regions of a DICOM series are not supported. " << std::endl; 
+    }
+    else if(fileExtension == ".nii" || fileExtension == ".nii.gz"){
+        isRead = MedImageParser::read_nii_region(filePath.c_str(), start, size, region, useIntensityScaling); 
+    }
+    else if(fileExtension == ".dcm"){
+        isRead = MedImageParser::read_dicom_region(filePath.c_str(), start, size, region, dicomSourceType); 
+    }
+    else if(fileExtension == ".nrrd"){
+        isRead = MedImageParser::read_nrrd_region(filePath.c_str(), start, size, region); 
+    }
+    else{
+        std::cout << fileName << " was not supported. " << std::endl; 
+    }
+
+    return isRead; 
+}
+
+bool MedicalImageIO::ReadSlice(int axis, int index, MedImageParser::FloatBuffer& slice){
+    if(axis < 0 || axis > 2){
+        std::cout << "ERROR: Slice axis must be 0, 1 or 2. " << std::endl; 
+        return false; 
+    }
+
+    //the slice extent comes from the header: 
+    if(!isHeaderAvailable && !ReadHeader()){
+        return false; 
+    }
+
+    int start[3] = {0, 0, 0}; 
+    int size[3] = {dimension[0], dimension[1], dimension[2]}; 
+    start[axis] = index; 
+    size[axis] = 1; 
+    return ReadRegion(start, size, slice); 
+}
+
+bool MedicalImageIO::ReadCached(){
+    //entries are keyed on one file, the slices of a series can change without touching the directory: 
+    if(isDicomSeries || !MedImageParser::VolumeCacheEnabled()){
+        return false; 
+    }
+
+    MedImageParser::CachedVolumeHeader header; 
+    MedImageParser::VolumeView cachedView; 
+    if(!MedImageParser::LoadCachedVolume(filePath, CacheOptions(), header, cachedView)){
+        return false; 
+    }
+
+    std::cout << fileName << " was loaded from the volume cache. " << std::endl; 
+    for(int axis = 0; axis < 3; ++axis){
+        dimension[axis] = header.dim[axis]; 
+        spacing[axis] = header.spacing[axis]; 
+        origin[axis] = header.origin[axis]; 
+    }
+    numberOfVolumes = header.numberOfVolumes; 
+
+    //the mapped entry stands in for the decoder buffer: 
+    dataBuffer.clear(); 
+    nativeView = cachedView; 
+    isViewMapped = true; 
+    isParsed = true; 
+    isBufferAvailable = true; 
+    isHeaderAvailable = true; 
+    return true; 
+}
+
+void MedicalImageIO::StoreCached(const float* voxels){
+    if(isDicomSeries || !MedImageParser::VolumeCacheEnabled()){
+        return; 
+    }
+
+    MedImageParser::CachedVolumeHeader header; 
+    for(int axis = 0; axis < 3; ++axis){
+        header.dim[axis] = dimension[axis]; 
+        header.spacing[axis] = spacing[axis]; 
+        header.origin[axis] = origin[axis]; 
+    }
+    header.numberOfVolumes = numberOfVolumes; 
+    MedImageParser::StoreCachedVolume(filePath, CacheOptions(), header, voxels); 
+}
+
+bool MedicalImageIO::ReadSeriesHeader(MedImageParser::DicomSeries& series){
+    if(!MedImageParser::scan_dicom_series(filePath.c_str(), series, std::string(), numberOfThreads, dicomSourceType)){
+        return false; 
+    }
+
+    for(int axis = 0; axis < 3; ++axis){
+        dimension[axis] = series.dim[axis]; 
+        spacing[axis] = series.spacing[axis]; 
+        origin[axis] = series.origin[axis]; 
+    }
+    for(int idx = 0; idx < 9; ++idx){
+        direction[idx] = series.direction[idx]; 
+    }
+    voxelType = series.voxelType; 
+    numberOfVolumes = 1; 
+    isHeaderAvailable = true; 
+    return true; 
+}
+
+bool MedicalImageIO::ReadDicom(const std::function<bool(const MedImageParser::VolumeView&)>& convert){
+    std::cout << "Dicom file was parsed. " << std::endl; 
+    nativeView = MedImageParser::VolumeView(); 
+
+    //a mapped view is converted from the file pages, and kept: 
+    bool isMapped = useMemoryMapping && MedImageParser::map_dicom( 
+        filePath.c_str(), 
+        dimension[0], dimension[1], dimension[2], 
+        spacing[0], spacing[1], spacing[2], 
+        origin[0], origin[1], origin[2], 
+        nativeView, dicomSourceType); 
+    isViewMapped = isMapped; 
+    if(isMapped){
+        isParsed = convert(nativeView); 
+    }
+    else{
+        isParsed = MedImageParser::read_dicom_pixels( 
+            filePath.c_str(), 
+            dimension[0], dimension[1], dimension[2], 
+            spacing[0], spacing[1], spacing[2], 
+            origin[0], origin[1], origin[2], 
+            dicomSourceType, convert); 
+    }
+
+    numberOfVolumes = 1; 
+    isHeaderAvailable = isParsed; 
+    return isParsed; 
+}
+
+uint32_t MedicalImageIO::CacheOptions(){
+    //bit 0: calibrated intensities: 
+    return useIntensityScaling ? 1u : 0u; 
+}
+
+bool MedicalImageIO::MaterializeBuffer(){
+    if(!dataBuffer.empty()){
+        return true; 
+    }
+    if(!nativeView.IsValid()){
+        return false; 
+    }
+
+    //a deferred conversion is added to the stats of the read that produced the view. 
+    //DICOM modality rescaling is always applied, as by the DICOM decoder: 
+    MedImageParser::ReadStatsScope statsScope(readStats); 
+    bool applyScaling = useIntensityScaling || fileExtension == ".dcm"; 
+    return MedImageParser::ConvertToFloat(nativeView, dataBuffer, applyScaling, numberOfThreads); 
+}
+
+std::future<bool> MedicalImageIO::ReadAsync(){
+    std::shared_ptr<std::promise<bool> > promise(new std::promise<bool>); 
+    std::future<bool> result = promise->get_future(); 
+
+    auto task = [this, promise](){
+        try{
+            promise->set_value(Read()); 
+        }
+        catch(...){
+            promise->set_exception(std::current_exception()); 
+        }
+    }; 
+
+    //a pool thread waiting on its own pool could deadlock, read right away there: 
+    if(MedImageParser::ThreadPool::InWorker()){
+        task(); 
+    }
+    else{
+        MedImageParser::ThreadPool::Shared().Submit(task); 
+    }
+    return result; 
+}
+
+void MedicalImageIO::ReadAsync(const std::function<void(MedicalImageIO& image, bool isRead)>& callback){
+    auto task = [this, callback](){
+        bool isRead = false; 
+        try{
+            isRead = Read(); 
+        }
+        catch(const std::exception& error){
+            std::cout << "File: " << filePath << ", failed to read: " << error.what() << std::endl; 
+        }
+        callback(*this, isRead); 
+    }; 
+    MedImageParser::ThreadPool::Shared().Submit(task); 
+}
+
+void MedicalImageIO::Prefetch(){
+#ifndef _WIN32
+    int fd = open(filePath.c_str(), O_RDONLY); 
+    if(fd < 0){
+        return; 
+    }
+#ifdef POSIX_FADV_WILLNEED
+    //readahead is started by the kernel, the call does not wait for it: 
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED); 
+#endif
+    close(fd); 
+#endif
+}
+
+bool MedicalImageIO::ReadMany(const std::vector<std::string>& filePaths, const ReadManyCallback& callback, bool inOrder, int maxInFlight) const{
+    struct LoadedImage{
+        std::unique_ptr<MedicalImageIO> image; 
+        bool isRead; 
+    }; 
+
+    //shared with the tasks, which may outlive this call if the callback throws: 
+    struct BatchState{
+        std::mutex mutex; 
+        std::condition_variable loaded; 
+        std::map<size_t, LoadedImage> ready; 
+    }; 
+    std::shared_ptr<BatchState> state(new BatchState); 
+
+    //nested batches from a pool thread run serially, waiting on the pool there could deadlock: 
+    MedImageParser::ThreadPool& pool = MedImageParser::ThreadPool::Shared(); 
+    bool isSerial = MedImageParser::ThreadPool::InWorker(); 
+    if(maxInFlight <= 0){
+        maxInFlight = 2 * pool.GetNumberOfThreads(); 
+    }
+
+    const bool mapping = useMemoryMapping; 
+    const bool scaling = useIntensityScaling; 
+    const int threads = numberOfThreads; 
+    const MedImageParser::DicomSourceType dicomSource = dicomSourceType; 
+    auto load = [state, mapping, scaling, threads, dicomSource](size_t index, std::string path){
+        LoadedImage loaded; 
+        loaded.image.reset(new MedicalImageIO(path)); 
+        loaded.image->SetMemoryMapping(mapping); 
+        loaded.image->SetIntensityScaling(scaling); 
+        loaded.image->SetNumberOfThreads(threads); 
+        loaded.image->SetDicomSource(dicomSource); 
+        loaded.isRead = false; 
+        try{
+            loaded.isRead = loaded.image->ReadableCheck() && loaded.image->Read(); 
+        }
+        catch(const std::exception& error){
+            std::cout << "File: " << path << ", failed to read: " << error.what() << std::endl; 
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex); 
+        state->ready[index] = std::move(loaded); 
+        state->loaded.notify_one(); 
+    }; 
+
+    bool allRead = true; 
+    size_t numSubmitted = 0; 
+    size_t numDelivered = 0; 
+    while(numDelivered < filePaths.size()){
+        //keep the pipeline full, delivered images free their slot: 
+        while(numSubmitted < filePaths.size() && numSubmitted - numDelivered < static_cast<size_t>(maxInFlight)){
+            if(isSerial){
+                load(numSubmitted, filePaths[numSubmitted]); 
+            }
+            else{
+                pool.Submit(std::bind(load, numSubmitted, filePaths[numSubmitted])); 
+            }
+            ++numSubmitted; 
+        }
+
+        LoadedImage next; 
+        size_t index = 0; 
+        {
+            std::unique_lock<std::mutex> lock(state->mutex); 
+            state->loaded.wait(lock, [&](){
+                return inOrder ? state->ready.count(numDelivered) > 0 : !state->ready.empty(); 
+            }); 
+            std::map<size_t, LoadedImage>::iterator found = inOrder ? state->ready.find(numDelivered) : state->ready.begin(); 
+            index = found->first; 
+            next = std::move(found->second); 
+            state->ready.erase(found); 
+        }
+
+        ++numDelivered; 
+        allRead = allRead && next.isRead; 
+        callback(index, *next.image, next.isRead); 
+    }
+
+    return allRead; 
 }
 
-void MedicalImageIO::DumpBufferOut(std::vector<float>& output){
+void MedicalImageIO::DumpBufferOut(MedImageParser::FloatBuffer& output){
     if(isParsed){
-        output.resize(dataBuffer.size(), 0.0f); 
-        std::copy(dataBuffer.begin(), dataBuffer.end(), output.begin()); 
+        MaterializeBuffer(); 
+        //hand the buffer over, the caller's old storage is released with ours: 
+        output.swap(dataBuffer); 
 
         //clear local memory: 
-        dataBuffer.clear(); 
+        MedImageParser::FloatBuffer().swap(dataBuffer); 
+        nativeView = MedImageParser::VolumeView(); 
         isBufferAvailable = false; 
     }
     else{
@@ -374,10 +2544,24 @@ void MedicalImageIO::DumpBufferOut(std::vector<float>& output){
 }
 
 void MedicalImageIO::DumpInfo(){
-    if(isParsed){
+    if(isParsed || isHeaderAvailable){
         std::cout << "Dimension: " << dimension[0] << ", " << dimension[1] << ", " << dimension[2] << std::endl; 
+        if(numberOfVolumes > 1){
+            std::cout << "Volumes: " << numberOfVolumes << std::endl; 
+        }
         std::cout << "Spacing: " << spacing[0] << ", " << spacing[1] << ", " << spacing[2] << std::endl; 
         std::cout << "Origin: " << origin[0] << ", " << origin[1] << ", " << origin[2] << std::endl; 
+        if(voxelType != MedImageParser::VOXEL_UNKNOWN){
+            std::cout << "Data type: " << MedImageParser::VoxelTypeName(voxelType) << std::endl; 
+            std::cout << "Direction: " 
+                << direction[0] << ", " << direction[1] << ", " << direction[2] << ", " 
+                << direction[3] << ", " << direction[4] << ", " << direction[5] << ", " 
+                << direction[6] << ", " << direction[7] << ", " << direction[8] << std::endl; 
+        }
+        if(readStats.numReads > 0){
+            std::cout << "Read: " << readStats.bytesRead << " bytes in " << readStats.totalMs << " [ms] (header: " 
+                << readStats.headerMs << ", decode: " << readStats.decodeMs << ", convert: " << readStats.convertMs << ") " << std::endl; 
+        }
     }
     else{
         std::cout << "File was not parsed. " << std::endl; 
@@ -398,7 +2582,8 @@ void MedicalImageIO::DumpToRaw(){
 
         std::string rawFilePath = basePath + "/" + baseName + ".raw"; 
 
-        Utilities::writeToBin(dataBuffer.data(), dimension[0] * dimension[1] * dimension[2], rawFilePath); 
+        MaterializeBuffer(); 
+        Utilities::writeToBin(dataBuffer.data(), static_cast<int>(dataBuffer.size()), rawFilePath); 
         std::cout << "Image file is written to " << rawFilePath << std::endl; 
     }
     else{
@@ -410,7 +2595,8 @@ void MedicalImageIO::DumpToRaw(std::string raw_path){
     if(isParsed){
         size_t found = raw_path.find(".raw"); 
         if(found != std::string::npos){
-            Utilities::writeToBin(dataBuffer.data(), dimension[0] * dimension[1] * dimension[2], raw_path); 
+            MaterializeBuffer(); 
+            Utilities::writeToBin(dataBuffer.data(), static_cast<int>(dataBuffer.size()), raw_path); 
             std::cout << "Image file is written to " << raw_path << std::endl; 
         }
         else{
@@ -458,14 +2644,37 @@ void MedicalImageIO::GetOrigin(float _origin[3]){
     _origin[2] = origin[2]; 
 }
 
+int MedicalImageIO::GetNumberOfVolumes(){
+    return numberOfVolumes; 
+}
+
+MedImageParser::VoxelType MedicalImageIO::GetVoxelType(){
+    return voxelType; 
+}
+
+void MedicalImageIO::GetDirection(float _direction[9]){
+    for(int idx = 0; idx < 9; ++idx){
+        _direction[idx] = direction[idx]; 
+    }
+}
+
 float* MedicalImageIO::GetRawBuffer(){
+    MaterializeBuffer(); 
     return dataBuffer.data(); 
 }
 
+const MedImageParser::VolumeView& MedicalImageIO::GetVolumeView(){
+    return nativeView; 
+}
+
 std::string MedicalImageIO::GetFileExtension(){
     return fileExtension; 
 }
 
+const MedImageParser::ReadStats& MedicalImageIO::GetReadStats(){
+    return readStats; 
+}
+
 std::string MedicalImageIO::GetFileName(){
     return fileName; 
 }
\ No newline at end of file
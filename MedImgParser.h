@@ -4,25 +4,290 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <new>
+#include <utility>
+
+#include "ReadStats.h"
+
+struct znzptr; 
 
 namespace MedImageParser
 {
 
+/* ------------------------------ Native voxel view ---------------------------- */ 
+enum VoxelType{
+    VOXEL_UNKNOWN = 0, 
+    VOXEL_UINT8, 
+    VOXEL_INT8, 
+    VOXEL_UINT16, 
+    VOXEL_INT16, 
+    VOXEL_UINT32, 
+    VOXEL_INT32, 
+    VOXEL_FLOAT32, 
+    VOXEL_FLOAT64
+}; 
+
+size_t VoxelTypeSize(VoxelType type); 
+const char* VoxelTypeName(VoxelType type); 
+
+//Typed, reference-counted view on the decoder's own voxel buffer. 
+//data points at voxel (0, 0, 0) in the same orientation as the float buffer, 
+//strides are in bytes and may be negative (e.g. the NIfTI vertical flip). 
+//dim[3] counts the 3D volumes (time points, vector components), 1 for plain volumes. 
+struct VolumeView{
+    VolumeView(); 
+
+    const unsigned char *data; 
+    VoxelType type; 
+    int dim[4]; 
+    std::ptrdiff_t stride[4]; 
+    bool byteSwapped; 
+
+    //intensity scaling stored with the data (NIfTI scl_slope / scl_inter), identity otherwise: 
+    float slope; 
+    float intercept; 
+    //low bits of each integer voxel that hold its value (DICOM Bits Stored), 0 when all do: 
+    int bitsStored; 
+
+    //keeps the decoder buffer alive for as long as any copy of the view exists: 
+    std::shared_ptr<const void> owner; 
+
+    bool IsValid() const; 
+    size_t NumberOfVoxels() const; 
+}; 
+
+/* ------------------------------ Float voxel buffer ---------------------------- */ 
+//Allocator that default-initializes new elements, so resize() leaves floats unwritten: 
+template <typename T>
+class DefaultInitAllocator : public std::allocator<T>{
+public: 
+    template <typename U> struct rebind{ typedef DefaultInitAllocator<U> other; }; 
+
+    DefaultInitAllocator() {} 
+    template <typename U> DefaultInitAllocator(const DefaultInitAllocator<U>&) {} 
+
+    template <typename U> void construct(U* ptr){ ::new(static_cast<void*>(ptr)) U; } 
+    template <typename U, typename... Args> void construct(U* ptr, Args&&... args){ 
+        ::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)...); 
+    } 
+}; 
+
+//Float output of all readers. Its pages are first written by the conversion that fills them: 
+typedef std::vector<float, DefaultInitAllocator<float> > FloatBuffer; 
+
+//Widen a native view to float32, honoring strides and byte order. 
+//applyScaling also maps the values through the view's slope and intercept. 
+//Large volumes are split into row slabs over numThreads threads of the shared pool 
+//(<= 0: all of them). Output pages not written before are first touched, and so placed 
+//on the NUMA node of, the thread converting their slab: 
+bool ConvertToFloat(const VolumeView& view, float* output); 
+bool ConvertToFloat(const VolumeView& view, float* output, bool applyScaling, int numThreads = 1); 
+//Same into a buffer sized to the view. It is not zero filled first, so Read() and the readers 
+//get that first touch for every slab and each output page is written once: 
+bool ConvertToFloat(const VolumeView& view, FloatBuffer& output, bool applyScaling = false, int numThreads = 1); 
+
 
 /* ------------------------------ IO routine for NIfTI (Neuroimaging Informatics Technology Initiative) ---------------------------- */ 
+//.nii.gz payloads are inflated in parallel only once an access point index of the file exists (see ParallelGzip.h). 
+//Except for BGZF files, the first read of a file is serial and builds it. Indices stay in a 64 MB in-process cache, 
+//about 3% of the uncompressed size each, so a set of files larger than about 2 GB uncompressed keeps evicting them 
+//and is read serially every time, unless set_gz_index_cache_limit() covers it or set_gz_index_sidecars(2) saves them. 
+//applyScaling returns calibrated values, voxel * scl_slope + scl_inter, from the same conversion pass: 
 bool read_nii( 
     const char *filename, 
     int& dimX, int& dimY, int& dimZ, 
     float& spacingX, float& spacingY, float& spacingZ, 
-    float& originX, float& originY, float& originZ, std::vector<float>& ImageBuff); 
+    float& originX, float& originY, float& originZ, FloatBuffer& ImageBuff, 
+    bool applyScaling = false); 
+
+bool read_nii( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, VolumeView& view); 
+
+//Zero-copy view on the memory mapped file, false if the payload needs decoding: 
+bool map_nii( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, VolumeView& view); 
+
+//Geometry, stored voxel type and row-major direction cosines, voxel data is not read: 
+bool read_nii_header( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VoxelType& voxelType, float direction[9], int& numberOfVolumes); 
+
+//Voxels [start, start + size) in the orientation of the float buffer, x fastest. 
+//Only the rows of the region are read, .nii.gz files seek through znzlib: 
+bool read_nii_region( 
+    const char *filename, 
+    const int start[3], const int size[3], 
+    FloatBuffer& ImageBuff, bool applyScaling = false); 
+
+//3D volumes of a 4D / 5D NIfTI file one at a time, with only one volume in memory. 
+//Volumes are numbered in file order, time points first, then vector components: 
+class NiftiVolumeStream{
+public: 
+    NiftiVolumeStream(); 
+    ~NiftiVolumeStream(); 
+
+    bool Open(const char *filename); 
+    void Close(); 
+
+    int GetNumberOfVolumes() const; 
+    int GetNumberOfTimepoints() const; 
+    int GetNumberOfComponents() const; 
+    void GetDimension(int _dim[3]) const; 
+
+    //next volume in file order, false after the last one: 
+    bool Next(FloatBuffer& volume, bool applyScaling = false); 
+    //any volume, .nii.gz files seek through znzlib: 
+    bool ReadVolume(int index, FloatBuffer& volume, bool applyScaling = false); 
+
+private: 
+    NiftiVolumeStream(const NiftiVolumeStream&); 
+    NiftiVolumeStream& operator=(const NiftiVolumeStream&); 
+
+    struct znzptr *file; 
+    int dim[3]; 
+    int numTimepoints; 
+    int numComponents; 
+    int nextVolume; 
+    int64_t payloadOffset; 
+    int64_t filePosition; 
+
+    //layout of a single volume and the bytes of the last one read: 
+    VolumeView layout; 
+    std::vector<unsigned char> volumeBytes; 
+}; 
 
 
 /* ------------------------------ IO routine for DICOM ---------------------------- */ 
+//How the DICOM parser reads a file. Mapped: the file is mapped (read in one call where it 
+//cannot be) and tags are read from memory. Stream: an ifstream read per tag field: 
+enum DicomSourceType{
+    DICOM_SOURCE_MAPPED, 
+    DICOM_SOURCE_STREAM
+}; 
+
 bool read_dicom( 
     const char *filename, 
     int& dimX, int& dimY, int& dimZ, 
     float& spacingX, float& spacingY, float& spacingZ, 
-    float& originX, float& originY, float& originZ, std::vector<float>& ImageBuff); 
+    float& originX, float& originY, float& originZ, FloatBuffer& ImageBuff, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+bool read_dicom( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, VolumeView& view, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+bool map_dicom( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, VolumeView& view, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+bool read_dicom_header( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VoxelType& voxelType, float direction[9], 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+//Rows are read at their frame offset, unless the pixel data needs decoding: 
+bool read_dicom_region( 
+    const char *filename, 
+    const int start[3], const int size[3], 
+    FloatBuffer& ImageBuff, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+
+/* ------------------------------ DICOM directory scan ---------------------------- */ 
+//Metadata of one file, parsed up to (7FE0,0010), the pixel data is neither read nor copied. 
+//dim: columns, rows, frames. voxelType is the stored type, float for rescaled images: 
+struct DicomFileHeader{
+    DicomFileHeader(); 
+
+    std::string filePath; 
+    std::string patientID; 
+    std::string studyID; 
+    std::string seriesUID; 
+    std::string seriesDescription; 
+    std::string modality; 
+    int dim[3]; 
+    float spacing[3]; 
+    float imagePosition[3]; 
+    float orientation[6]; 
+    VoxelType voxelType; 
+    //-1 for encapsulated or missing pixel data: 
+    long pixelDataOffset; 
+}; 
+
+bool read_dicom_file_header(const char *filename, DicomFileHeader& header, DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+//Headers of many files, parsed in parallel on the shared pool (numThreads <= 0: all of its threads). 
+//Files that are no DICOM are skipped, headers are in the order of filePaths: 
+bool scan_dicom_files( 
+    const std::vector<std::string>& filePaths, 
+    std::vector<DicomFileHeader>& headers, int numThreads = 0, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+//Same for the files of a directory, with recursive its subdirectories too, in path order: 
+bool scan_dicom_directory( 
+    const char *directory, 
+    std::vector<DicomFileHeader>& headers, 
+    bool recursive = true, int numThreads = 0, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+
+/* ------------------------------ IO routine for DICOM series ---------------------------- */ 
+//One volume stacked from single-slice files. filePaths are ordered along the slice normal, 
+//the first slice is at the origin. voxelType is the stored type, float for rescaled slices: 
+struct DicomSeries{
+    DicomSeries(); 
+
+    std::string seriesUID; 
+    std::vector<std::string> filePaths; 
+    int dim[3]; 
+    float spacing[3]; 
+    float origin[3]; 
+    float direction[9]; 
+    VoxelType voxelType; 
+}; 
+
+//The slice headers are scanned with scan_dicom_files() and grouped by SeriesInstanceUID. 
+//seriesUID empty: the series with the most slices. Files that are no DICOM are skipped. 
+//numThreads <= 0: all threads of the shared pool: 
+bool scan_dicom_series( 
+    const std::vector<std::string>& filePaths, 
+    DicomSeries& series, 
+    const std::string& seriesUID = std::string(), int numThreads = 0, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+bool scan_dicom_series( 
+    const char *directory, 
+    DicomSeries& series, 
+    const std::string& seriesUID = std::string(), int numThreads = 0, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
+
+//Slices are decoded concurrently, each straight into its z offset of output (dim[0] * dim[1] * dim[2] floats): 
+bool read_dicom_series( 
+    const DicomSeries& series, float* output, int numThreads = 0, 
+    DicomSourceType sourceType = DICOM_SOURCE_MAPPED); 
 
 
 /* ------------------------------ IO routine for nrrd ---------------------------- */ 
@@ -30,7 +295,32 @@ bool read_nrrd(
     const char *filename, 
     int& dimX, int& dimY, int& dimZ, 
     float& spacingX, float& spacingY, float& spacingZ, 
-    float& originX, float& originY, float& originZ, std::vector<float>& ImageBuff); 
+    float& originX, float& originY, float& originZ, FloatBuffer& ImageBuff); 
+
+bool read_nrrd( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, VolumeView& view); 
+
+bool map_nrrd( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, VolumeView& view); 
+
+bool read_nrrd_header( 
+    const char *filename, 
+    int& dimX, int& dimY, int& dimZ, 
+    float& spacingX, float& spacingY, float& spacingZ, 
+    float& originX, float& originY, float& originZ, 
+    VoxelType& voxelType, float direction[9]); 
+
+//Rows are read in place for raw encoding, compressed encodings are decoded first: 
+bool read_nrrd_region( 
+    const char *filename, 
+    const int start[3], const int size[3], 
+    FloatBuffer& ImageBuff); 
 
 }
 
@@ -39,6 +329,7 @@ bool read_nrrd(
 class MedicalImageIO{
 
 public: 
+    //a directory path reads the largest DICOM series in it, see scan_dicom_series(): 
     MedicalImageIO(); 
     MedicalImageIO(std::string _filePath); 
     MedicalImageIO(const char *_filePath); 
@@ -48,9 +339,44 @@ public:
     bool BufferAvailable(); 
     bool HeaderAvailable(); 
 
+    //map uncompressed payloads instead of reading them, falls back to the decoders: 
+    void SetMemoryMapping(bool enable); 
+    //calibrated NIfTI intensities (scl_slope / scl_inter) in Read(), ReadRegion() and ReadSlice(): 
+    void SetIntensityScaling(bool enable); 
+    //threads converting one volume to float, <= 0 (default): all threads of the shared pool. 
+    //Files of ReadMany() are converted on one thread each: 
+    void SetNumberOfThreads(int numThreads); 
+    //how DICOM files are parsed, mapped by default: 
+    void SetDicomSource(MedImageParser::DicomSourceType sourceType); 
+
+    //both Read() calls go through the decoded volume cache once SetVolumeCacheDirectory() is set: 
     bool Read(); 
+    //convert straight into a caller buffer of at least numVoxels floats, e.g. one reused across files. 
+    //the object keeps the header only: 
+    bool Read(float* output, size_t numVoxels); 
+    bool ReadNative(); 
+    bool ReadHeader(); 
+
+    //Read() on the shared thread pool. The object must outlive the read and is not touched 
+    //until the future is ready / the callback has run (on a pool thread): 
+    std::future<bool> ReadAsync(); 
+    void ReadAsync(const std::function<void(MedicalImageIO& image, bool isRead)>& callback); 
+    //ask the OS to start loading the file into the page cache, e.g. a few reads ahead: 
+    void Prefetch(); 
+
+    //parts of the volume, the rest is not decoded and the float buffer is left alone. 
+    //slices along axis 0 / 1 / 2 are laid out (y, z) / (x, z) / (x, y), first index fastest: 
+    bool ReadRegion(const int start[3], const int size[3], MedImageParser::FloatBuffer& region); 
+    bool ReadSlice(int axis, int index, MedImageParser::FloatBuffer& slice); 
+
+    //Batch loading on the shared thread pool, with this object's settings (memory mapping, intensity scaling, threads). 
+    //callback runs on the calling thread for every file, with its index in filePaths and the read image, 
+    //in the order of filePaths or, with inOrder false, as the files complete. At most maxInFlight images 
+    //(<= 0: twice the pool threads) are being read or waiting for the callback. True if all were read: 
+    typedef std::function<void(size_t index, MedicalImageIO& image, bool isRead)> ReadManyCallback; 
+    bool ReadMany(const std::vector<std::string>& filePaths, const ReadManyCallback& callback, bool inOrder = true, int maxInFlight = 0) const; 
 
-    void DumpBufferOut(std::vector<float>& output); 
+    void DumpBufferOut(MedImageParser::FloatBuffer& output); 
     void DumpInfo(); 
     void DumpToRaw(); 
     void DumpToRaw(std::string raw_path); 
@@ -61,15 +387,28 @@ public:
     void GetSpacing(float _spacing[3]); 
     void GetOrigin(float& originX, float& originY, float& originZ); 
     void GetOrigin(float _origin[3]); 
+    //3D volumes in the file, the float buffer holds them one after another: 
+    int GetNumberOfVolumes(); 
+    //voxel type and direction are filled by ReadHeader(): 
+    MedImageParser::VoxelType GetVoxelType(); 
+    void GetDirection(float _direction[9]); 
     float* GetRawBuffer(); 
+    const MedImageParser::VolumeView& GetVolumeView(); 
     std::string GetFileExtension(); 
     std::string GetFileName(); 
 
+    //bytes, allocations and stage times of the last Read(), ReadNative(), ReadHeader() or ReadRegion(), 
+    //with the conversion on first buffer access. Totals over all reads: MedImageParser::GetProcessReadStats(): 
+    const MedImageParser::ReadStats& GetReadStats(); 
+
 private: 
     //geometry parameter: 
     int dimension[3]; 
+    int numberOfVolumes; 
     float spacing[3]; 
     float origin[3]; 
+    float direction[9]; 
+    MedImageParser::VoxelType voxelType; 
 
     //path: 
     std::string filePath; 
@@ -78,13 +417,40 @@ private:
     std::vector<std::string> readableExtensions; 
 
     //data buffer: 
-    std::vector<float> dataBuffer; 
+    MedImageParser::FloatBuffer dataBuffer; 
+    MedImageParser::VolumeView nativeView; 
+
+    //float conversion of the native view, applied on first access: 
+    bool MaterializeBuffer(); 
+
+    //decoded volume cache, see VolumeCache.h: 
+    bool ReadCached(); 
+    void StoreCached(const float* voxels); 
+    uint32_t CacheOptions(); 
+
+    //DICOM series of a directory path, geometry from the slice headers: 
+    bool ReadSeriesHeader(MedImageParser::DicomSeries& series); 
+    //single DICOM file, its stored voxels are passed to convert in the parse that reads them: 
+    bool ReadDicom(const std::function<bool(const MedImageParser::VolumeView&)>& convert); 
+
+    //instrumentation of the read in progress / last read: 
+    MedImageParser::ReadStats readStats; 
+    bool isRecordingStats; 
+
+    //file path is a directory of DICOM slices: 
+    bool isDicomSeries; 
 
     //flags: 
     bool isReadable; 
     bool isParsed; 
     bool isBufferAvailable; 
     bool isHeaderAvailable; 
+    //nativeView is a mapping of the file or of a cache entry, not a decoder buffer: 
+    bool isViewMapped; 
+    bool useMemoryMapping; 
+    bool useIntensityScaling; 
+    int numberOfThreads; 
+    MedImageParser::DicomSourceType dicomSourceType; 
 }; 
 
 #endif
\ No newline at end of file
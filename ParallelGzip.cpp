@@ -0,0 +1,171 @@
+#include "ParallelGzip.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "utilities.h"
+#include "ThreadPool.h"
+#include "ReadStats.h"
+#include "zlib/gzindex.h"
+
+namespace MedImageParser
+{
+
+//access point indices of files already inflated, kept in the bounded cache of gzindex.c 
+//shared with the seeks of znzlib: 
+typedef std::shared_ptr<gzindex> GzipIndexPtr; 
+
+static GzipIndexPtr FindGzipIndex(const char *path, size_t compressedLength)
+{
+    return GzipIndexPtr(gzindex_cache_find(path, compressedLength), gzindex_cache_release); 
+}
+
+static GzipIndexPtr StoreGzipIndex(const char *path, gzindex *index)
+{
+    return GzipIndexPtr(gzindex_cache_store(path, index), gzindex_cache_release); 
+}
+
+//inflate [0, length) as independent ranges, each starting at an access point: 
+static bool ExtractParallel(
+    const unsigned char *compressed, size_t compressedLength,
+    const gzindex *index, unsigned char *output, size_t length, int numThreads)
+{
+    //about four ranges per thread keeps the threads balanced: 
+    size_t target = std::max<size_t>(length / (static_cast<size_t>(numThreads) * 4), 1); 
+
+    std::vector<size_t> cuts(1, 0); 
+    for(int idx = 1; idx < index->have; ++idx){
+        size_t pointOut = index->list[idx].out; 
+        if(pointOut >= length){
+            break; 
+        }
+        if(pointOut - cuts.back() >= target){
+            cuts.push_back(pointOut); 
+        }
+    }
+    cuts.push_back(length); 
+
+    int numRanges = static_cast<int>(cuts.size() - 1); 
+    std::atomic<bool> failed(false); 
+
+    RunParallel(numRanges, numThreads, [&](int range){
+        if(failed){
+            return; 
+        }
+        size_t rangeLength = cuts[range + 1] - cuts[range]; 
+        long long inflated = gzindex_extract(
+            compressed, compressedLength, index,
+            cuts[range], output + cuts[range], rangeLength); 
+        if(inflated != static_cast<long long>(rangeLength)){
+            failed = true; 
+        }
+    }); 
+
+    return !failed; 
+}
+
+void set_gz_index_sidecars(int mode)
+{
+    gzindex_set_sidecar_mode(mode); 
+}
+
+void set_gz_index_cache_limit(size_t bytes)
+{
+    gzindex_set_cache_limit(bytes); 
+}
+
+size_t get_gz_index_cache_limit()
+{
+    return gzindex_cache_limit(); 
+}
+
+bool inflate_gz(const char *filename, unsigned char *output, size_t length, int numThreads)
+{
+    //files read on the pool are already parallel, one inflate thread each: 
+    numThreads = PoolThreads(numThreads); 
+
+    struct stat fileStat; 
+    if(stat(filename, &fileStat) != 0){
+        std::cout << "File: " << filename << ", failed to open. " << std::endl; 
+        return false; 
+    }
+    Utilities::MyTimer timer; 
+    timer.tic(); 
+
+    //compressed stream, mapped or read in one piece: 
+    Utilities::MappedFile mappedFile; 
+    std::vector<unsigned char> fileContent; 
+    const unsigned char *compressed = NULL; 
+    size_t compressedLength = 0; 
+    if(mappedFile.Open(filename)){
+        compressed = mappedFile.Data(); 
+        compressedLength = mappedFile.Size(); 
+    }
+    else{
+        std::ifstream inputStream(filename, std::ios::in | std::ios::binary); 
+        fileContent.assign(std::istreambuf_iterator<char>(inputStream), std::istreambuf_iterator<char>()); 
+        compressed = fileContent.data(); 
+        compressedLength = fileContent.size(); 
+    }
+
+    GzipIndexPtr index = FindGzipIndex(filename, compressedLength); 
+
+    //an index saved by an earlier process: 
+    if(!index){
+        gzindex *loaded = NULL; 
+        if(gzindex_sidecar_load(filename, compressedLength, &loaded) == Z_OK){
+            index = StoreGzipIndex(filename, loaded); 
+        }
+    }
+
+    //BGZF members carry their own sizes, indexed without inflating: 
+    if(!index){
+        gzindex *built = NULL; 
+        if(gzindex_build_bgzf(compressed, compressedLength, &built) == Z_OK){
+            gzindex_sidecar_save(filename, built); 
+            index = StoreGzipIndex(filename, built); 
+        }
+    }
+
+    //single pass, the stream is inflated serially and indexed for the next read: 
+    if(!index){
+        gzindex *built = NULL; 
+        if(gzindex_build(compressed, compressedLength, GZINDEX_SPAN, output, length, &built) != Z_OK){
+            std::cout << "File: " << filename << ", failed to inflate. " << std::endl; 
+            return false; 
+        }
+        gzindex_sidecar_save(filename, built); 
+        index = StoreGzipIndex(filename, built); 
+
+        if(index->length < length){
+            std::cout << "File: " << filename << ", inflated data is shorter than expected. " << std::endl; 
+            return false; 
+        }
+        timer.toc(); 
+        RecordBytesRead(compressedLength); 
+        RecordInflate(length, timer.Duration()); 
+        return true; 
+    }
+
+    if(index->length < length){
+        std::cout << "File: " << filename << ", inflated data is shorter than expected. " << std::endl; 
+        return false; 
+    }
+
+    if(!ExtractParallel(compressed, compressedLength, index.get(), output, length, numThreads)){
+        std::cout << "File: " << filename << ", failed to inflate. " << std::endl; 
+        return false; 
+    }
+    timer.toc(); 
+    RecordBytesRead(compressedLength); 
+    RecordInflate(length, timer.Duration()); 
+    return true; 
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef PARALLELGZIP
+#define PARALLELGZIP
+
+#include <cstddef>
+
+namespace MedImageParser
+{
+
+/* ------------------------------ Parallel gzip inflate ---------------------------- */ 
+//Inflate the first length bytes of a gzip file into output. 
+//BGZF / multi-member files are split at their members right away. Other files are
+//inflated serially once while an access point index is recorded, later reads of the
+//same file then inflate the ranges between access points concurrently. 
+//numThreads <= 0 uses all threads of the shared ThreadPool, on a pool thread the calling one only. 
+bool inflate_gz(const char *filename, unsigned char *output, size_t length, int numThreads = 0); 
+
+//Access point indices are shared in the process with the seeks in .nii.gz files through znzlib, 
+//and can also be kept next to the gzip files (<file>.gzidx) for later processes: 
+//0: never use them, 1: use existing ones (default), 2: also write them once indexed. 
+void set_gz_index_sidecars(int mode); 
+
+//Indices are kept in memory for the files read last, up to a limit on their size 
+//(about 32 KB per access point, 3% of the uncompressed size, 64 MB by default). 0 keeps none. 
+//Files whose index was evicted are inflated serially again, size the limit to the files read repeatedly: 
+void set_gz_index_cache_limit(size_t bytes); 
+size_t get_gz_index_cache_limit(); 
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include "ReadStats.h"
+
+#include <atomic>
+#include <cstddef>
+
+namespace MedImageParser
+{
+
+ReadStats::ReadStats()
+{
+    numReads = 0; 
+    bytesRead = 0; 
+    bytesInflated = 0; 
+    bytesConverted = 0; 
+    allocations = 0; 
+    allocatedBytes = 0; 
+    reusedAllocations = 0; 
+    headerMs = 0.0; 
+    decodeMs = 0.0; 
+    inflateMs = 0.0; 
+    convertMs = 0.0; 
+    totalMs = 0.0; 
+}
+
+void ReadStats::Add(const ReadStats& other)
+{
+    numReads += other.numReads; 
+    bytesRead += other.bytesRead; 
+    bytesInflated += other.bytesInflated; 
+    bytesConverted += other.bytesConverted; 
+    allocations += other.allocations; 
+    allocatedBytes += other.allocatedBytes; 
+    reusedAllocations += other.reusedAllocations; 
+    headerMs += other.headerMs; 
+    decodeMs += other.decodeMs; 
+    inflateMs += other.inflateMs; 
+    convertMs += other.convertMs; 
+    totalMs += other.totalMs; 
+}
+
+//process-wide counters, times in nanoseconds so that they can be atomic integers: 
+struct ProcessCounters{
+    std::atomic<uint64_t> numReads; 
+    std::atomic<uint64_t> bytesRead; 
+    std::atomic<uint64_t> bytesInflated; 
+    std::atomic<uint64_t> bytesConverted; 
+    std::atomic<uint64_t> allocations; 
+    std::atomic<uint64_t> allocatedBytes; 
+    std::atomic<uint64_t> reusedAllocations; 
+    std::atomic<uint64_t> headerNs; 
+    std::atomic<uint64_t> decodeNs; 
+    std::atomic<uint64_t> inflateNs; 
+    std::atomic<uint64_t> convertNs; 
+    std::atomic<uint64_t> totalNs; 
+}; 
+
+static ProcessCounters processCounters; 
+static thread_local ReadStats *currentStats = NULL; 
+
+static uint64_t ToNanoseconds(double milliseconds)
+{
+    return (milliseconds > 0.0) ? static_cast<uint64_t>(milliseconds * 1.0e6) : 0; 
+}
+
+ReadStats GetProcessReadStats()
+{
+    ReadStats stats; 
+    stats.numReads = processCounters.numReads; 
+    stats.bytesRead = processCounters.bytesRead; 
+    stats.bytesInflated = processCounters.bytesInflated; 
+    stats.bytesConverted = processCounters.bytesConverted; 
+    stats.allocations = processCounters.allocations; 
+    stats.allocatedBytes = processCounters.allocatedBytes; 
+    stats.reusedAllocations = processCounters.reusedAllocations; 
+    stats.headerMs = processCounters.headerNs / 1.0e6; 
+    stats.decodeMs = processCounters.decodeNs / 1.0e6; 
+    stats.inflateMs = processCounters.inflateNs / 1.0e6; 
+    stats.convertMs = processCounters.convertNs / 1.0e6; 
+    stats.totalMs = processCounters.totalNs / 1.0e6; 
+    return stats; 
+}
+
+void ResetProcessReadStats()
+{
+    processCounters.numReads = 0; 
+    processCounters.bytesRead = 0; 
+    processCounters.bytesInflated = 0; 
+    processCounters.bytesConverted = 0; 
+    processCounters.allocations = 0; 
+    processCounters.allocatedBytes = 0; 
+    processCounters.reusedAllocations = 0; 
+    processCounters.headerNs = 0; 
+    processCounters.decodeNs = 0; 
+    processCounters.inflateNs = 0; 
+    processCounters.convertNs = 0; 
+    processCounters.totalNs = 0; 
+}
+
+ReadStatsScope::ReadStatsScope(ReadStats& stats)
+{
+    previous = currentStats; 
+    currentStats = &stats; 
+}
+
+ReadStatsScope::~ReadStatsScope()
+{
+    currentStats = previous; 
+}
+
+void RecordRead(double totalMs)
+{
+    processCounters.numReads += 1; 
+    processCounters.totalNs += ToNanoseconds(totalMs); 
+    if(currentStats != NULL){
+        currentStats->numReads += 1; 
+        currentStats->totalMs += totalMs; 
+    }
+}
+
+void RecordHeader(double milliseconds)
+{
+    processCounters.headerNs += ToNanoseconds(milliseconds); 
+    if(currentStats != NULL){
+        currentStats->headerMs += milliseconds; 
+    }
+}
+
+void RecordBytesRead(uint64_t bytesRead)
+{
+    processCounters.bytesRead += bytesRead; 
+    if(currentStats != NULL){
+        currentStats->bytesRead += bytesRead; 
+    }
+}
+
+void RecordDecode(double milliseconds)
+{
+    processCounters.decodeNs += ToNanoseconds(milliseconds); 
+    if(currentStats != NULL){
+        currentStats->decodeMs += milliseconds; 
+    }
+}
+
+void RecordInflate(uint64_t bytesInflated, double milliseconds)
+{
+    processCounters.bytesInflated += bytesInflated; 
+    processCounters.inflateNs += ToNanoseconds(milliseconds); 
+    if(currentStats != NULL){
+        currentStats->bytesInflated += bytesInflated; 
+        currentStats->inflateMs += milliseconds; 
+    }
+}
+
+void RecordConvert(uint64_t bytesConverted, double milliseconds)
+{
+    processCounters.bytesConverted += bytesConverted; 
+    processCounters.convertNs += ToNanoseconds(milliseconds); 
+    if(currentStats != NULL){
+        currentStats->bytesConverted += bytesConverted; 
+        currentStats->convertMs += milliseconds; 
+    }
+}
+
+void RecordAllocation(uint64_t bytes, bool isReused)
+{
+    processCounters.allocations += 1; 
+    processCounters.allocatedBytes += bytes; 
+    processCounters.reusedAllocations += isReused ? 1 : 0; 
+    if(currentStats != NULL){
+        currentStats->allocations += 1; 
+        currentStats->allocatedBytes += bytes; 
+        currentStats->reusedAllocations += isReused ? 1 : 0; 
+    }
+}
+
+void AddToCurrentReadStats(const ReadStats& stats)
+{
+    if(currentStats != NULL){
+        currentStats->Add(stats); 
+    }
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef READSTATS
+#define READSTATS
+
+#include <cstdint>
+
+namespace MedImageParser
+{
+
+/* ------------------------------ Read instrumentation ---------------------------- */ 
+//Where a read spends its time and memory. Filled per read by MedicalImageIO
+//(GetReadStats()) and summed over the whole process (GetProcessReadStats()). 
+//Times are in milliseconds, inflateMs is part of decodeMs. 
+struct ReadStats{
+    ReadStats(); 
+    void Add(const ReadStats& other); 
+
+    uint64_t numReads; 
+    //file bytes read or mapped, compressed bytes for compressed files: 
+    uint64_t bytesRead; 
+    //bytes produced by gzip / NRRD decoding: 
+    uint64_t bytesInflated; 
+    //float bytes written by the conversion: 
+    uint64_t bytesConverted; 
+    //decode buffers, those served by the buffer pool are counted as reused: 
+    uint64_t allocations; 
+    uint64_t allocatedBytes; 
+    uint64_t reusedAllocations; 
+
+    double headerMs; 
+    double decodeMs; 
+    double inflateMs; 
+    double convertMs; 
+    double totalMs; 
+}; 
+
+ReadStats GetProcessReadStats(); 
+void ResetProcessReadStats(); 
+
+//Counters of the reads on this thread go to stats while the scope lives, scopes nest: 
+class ReadStatsScope{
+public:
+    explicit ReadStatsScope(ReadStats& stats); 
+    ~ReadStatsScope(); 
+
+private:
+    ReadStatsScope(const ReadStatsScope&); 
+    ReadStatsScope& operator=(const ReadStatsScope&); 
+
+    ReadStats *previous; 
+}; 
+
+//used by the readers, recorded for the current scope and the process: 
+void RecordRead(double totalMs); 
+void RecordHeader(double milliseconds); 
+void RecordBytesRead(uint64_t bytesRead); 
+void RecordDecode(double milliseconds); 
+void RecordInflate(uint64_t bytesInflated, double milliseconds); 
+void RecordConvert(uint64_t bytesConverted, double milliseconds); 
+void RecordAllocation(uint64_t bytes, bool isReused); 
+//stats gathered in scopes on other threads, added to the current scope only, the process has them already: 
+void AddToCurrentReadStats(const ReadStats& stats); 
+
+}
+
+#endif
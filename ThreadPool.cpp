@@ -0,0 +1,180 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace MedImageParser
+{
+
+//pool and queue of the current thread, NULL outside of the workers: 
+static thread_local ThreadPool *currentPool = NULL; 
+static thread_local int currentQueue = -1; 
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    if(numThreads <= 0){
+        numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency())); 
+    }
+
+    nextQueue = 0; 
+    numQueued = 0; 
+    stopping = false; 
+    for(int idx = 0; idx < numThreads; ++idx){
+        queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue)); 
+    }
+    for(int idx = 0; idx < numThreads; ++idx){
+        threads.push_back(std::thread(&ThreadPool::WorkerLoop, this, idx)); 
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex); 
+        stopping = true; 
+    }
+    wakeUp.notify_all(); 
+    for(size_t idx = 0; idx < threads.size(); ++idx){
+        threads[idx].join(); 
+    }
+}
+
+void ThreadPool::Submit(const std::function<void()>& task)
+{
+    //own queue from a worker of this pool, round robin otherwise: 
+    int target = (currentPool == this) ? currentQueue : static_cast<int>(nextQueue++ % queues.size()); 
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex); 
+        queues[target]->tasks.push_back(task); 
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex); 
+        ++numQueued; 
+    }
+    wakeUp.notify_one(); 
+}
+
+int ThreadPool::GetNumberOfThreads() const
+{
+    return static_cast<int>(threads.size()); 
+}
+
+bool ThreadPool::InWorker()
+{
+    return currentPool != NULL; 
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    //never destroyed, workers may still be running during static destruction: 
+    static ThreadPool *pool = new ThreadPool; 
+    return *pool; 
+}
+
+bool ThreadPool::TakeTask(int self, std::function<void()>& task)
+{
+    //own tasks in submission order, batches are delivered in that order: 
+    {
+        TaskQueue& own = *queues[self]; 
+        std::lock_guard<std::mutex> lock(own.mutex); 
+        if(!own.tasks.empty()){
+            task = own.tasks.front(); 
+            own.tasks.pop_front(); 
+            return true; 
+        }
+    }
+
+    //newest task of another worker, its owner keeps working from the other end: 
+    for(size_t offset = 1; offset < queues.size(); ++offset){
+        TaskQueue& victim = *queues[(self + offset) % queues.size()]; 
+        std::lock_guard<std::mutex> lock(victim.mutex); 
+        if(!victim.tasks.empty()){
+            task = victim.tasks.back(); 
+            victim.tasks.pop_back(); 
+            return true; 
+        }
+    }
+    return false; 
+}
+
+void ThreadPool::WorkerLoop(int self)
+{
+    currentPool = this; 
+    currentQueue = self; 
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex); 
+            wakeUp.wait(lock, [this](){ return numQueued > 0 || stopping; }); 
+            if(numQueued == 0){
+                return; 
+            }
+            --numQueued; 
+        }
+
+        //a task is queued for this claim, possibly still being pushed: 
+        std::function<void()> task; 
+        while(!TakeTask(self, task)){
+            std::this_thread::yield(); 
+        }
+        task(); 
+    }
+}
+
+//threads of the shared pool a parallel step may use, the calling thread included: 
+int PoolThreads(int numThreads)
+{
+    //a pool thread waiting on its own pool could deadlock: 
+    if(numThreads == 1 || ThreadPool::InWorker()){
+        return 1; 
+    }
+
+    //the pool has one thread per core, the calling thread takes the place of one of them: 
+    int poolThreads = ThreadPool::Shared().GetNumberOfThreads(); 
+    if(numThreads <= 0 || numThreads > poolThreads){
+        numThreads = poolThreads; 
+    }
+    return numThreads; 
+}
+
+//Items [0, numItems) run by the calling thread and numThreads - 1 pool threads, 
+//every thread takes the next item until none is left. Returns after the last item: 
+void RunParallel(int numItems, int numThreads, const std::function<void(int item)>& body)
+{
+    struct ItemWork{
+        std::function<void(int item)> body; 
+        int numItems; 
+        std::atomic<int> nextItem; 
+        std::mutex mutex; 
+        std::condition_variable finished; 
+        int numFinished; 
+    }; 
+
+    //helpers that start after the last item find nothing left and return: 
+    std::shared_ptr<ItemWork> work(new ItemWork); 
+    work->body = body; 
+    work->numItems = numItems; 
+    work->nextItem = 0; 
+    work->numFinished = 0; 
+
+    auto runItems = [work](){
+        int item; 
+        while((item = work->nextItem++) < work->numItems){
+            work->body(item); 
+
+            std::lock_guard<std::mutex> lock(work->mutex); 
+            if(++work->numFinished == work->numItems){
+                work->finished.notify_all(); 
+            }
+        }
+    }; 
+
+    for(int idx = 1; idx < std::min(numThreads, numItems); ++idx){
+        ThreadPool::Shared().Submit(runItems); 
+    }
+    runItems(); 
+
+    std::unique_lock<std::mutex> lock(work->mutex); 
+    work->finished.wait(lock, [&](){ return work->numFinished == work->numItems; }); 
+}
+
+}
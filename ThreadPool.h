@@ -0,0 +1,67 @@
+#ifndef THREADPOOL
+#define THREADPOOL
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace MedImageParser
+{
+
+/* ------------------------------ Work-stealing thread pool ---------------------------- */ 
+//Every worker has its own task queue, worked from the front. Tasks submitted from a worker 
+//go to its own queue, others are spread round robin. Idle workers steal from the back of the others. 
+//numThreads <= 0 uses all hardware threads. The destructor runs the queued tasks, then joins. 
+class ThreadPool{
+public:
+    explicit ThreadPool(int numThreads = 0); 
+    ~ThreadPool(); 
+
+    void Submit(const std::function<void()>& task); 
+    int GetNumberOfThreads() const; 
+
+    //true on the threads of any pool, e.g. to keep nested work serial: 
+    static bool InWorker(); 
+
+    //pool shared by the batch and asynchronous readers, created on first use: 
+    static ThreadPool& Shared(); 
+
+private:
+    ThreadPool(const ThreadPool&); 
+    ThreadPool& operator=(const ThreadPool&); 
+
+    struct TaskQueue{
+        std::mutex mutex; 
+        std::deque<std::function<void()> > tasks; 
+    }; 
+
+    void WorkerLoop(int self); 
+    bool TakeTask(int self, std::function<void()>& task); 
+
+    std::vector<std::unique_ptr<TaskQueue> > queues; 
+    std::vector<std::thread> threads; 
+    std::atomic<size_t> nextQueue; 
+
+    //workers sleep here while no task is queued: 
+    std::mutex sleepMutex; 
+    std::condition_variable wakeUp; 
+    size_t numQueued; 
+    bool stopping; 
+}; 
+
+//threads of the shared pool a parallel step may use, the calling thread included. 
+//numThreads <= 0 uses all pool threads, on a pool thread only the calling one is used: 
+int PoolThreads(int numThreads); 
+
+//Items [0, numItems) run by the calling thread and numThreads - 1 threads of the shared pool, 
+//every thread takes the next item until none is left. Returns after the last item: 
+void RunParallel(int numItems, int numThreads, const std::function<void(int item)>& body); 
+
+}
+
+#endif
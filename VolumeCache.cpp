@@ -0,0 +1,365 @@
+#include "VolumeCache.h"
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#include "utilities.h"
+
+namespace MedImageParser
+{
+
+static const char cacheMagic[8] = {'M', 'I', 'P', 'V', 'O', 'L', '1', '\0'}; 
+static const uint32_t cacheByteOrder = 0x01020304; 
+static const uint64_t cacheAlignment = 4096; 
+static const char cacheSuffix[] = ".mvol"; 
+//temporary files of writers that died are removed after an hour: 
+static const time_t staleTemporaryAge = 3600; 
+//numbers the temporary files of this process: 
+static std::atomic<unsigned long> temporaryCounter(0); 
+
+//fixed part of an entry, followed by the key and the page aligned float voxels: 
+struct CacheEntryHeader{
+    char magic[8]; 
+    uint32_t byteOrder; 
+    uint32_t keyLength; 
+    uint64_t dataOffset; 
+    uint64_t dataLength; 
+    uint64_t sourceSize; 
+    int64_t sourceSeconds; 
+    int64_t sourceNanoseconds; 
+    uint32_t options; 
+    int32_t dim[4]; 
+    float spacing[3]; 
+    float origin[3]; 
+    uint32_t reserved; 
+}; 
+
+struct CacheSettings{
+    CacheSettings(){
+        limit = static_cast<uint64_t>(16) << 30; 
+    }
+
+    std::mutex mutex; 
+    std::string directory; 
+    uint64_t limit; 
+}; 
+
+static CacheSettings& Settings()
+{
+    static CacheSettings settings; 
+    return settings; 
+}
+
+void SetVolumeCacheDirectory(const std::string& directory)
+{
+    std::lock_guard<std::mutex> lock(Settings().mutex); 
+    Settings().directory = directory; 
+}
+
+std::string GetVolumeCacheDirectory()
+{
+    std::lock_guard<std::mutex> lock(Settings().mutex); 
+    return Settings().directory; 
+}
+
+bool VolumeCacheEnabled()
+{
+    return !GetVolumeCacheDirectory().empty(); 
+}
+
+void SetVolumeCacheLimit(uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(Settings().mutex); 
+    Settings().limit = bytes; 
+}
+
+uint64_t GetVolumeCacheLimit()
+{
+    std::lock_guard<std::mutex> lock(Settings().mutex); 
+    return Settings().limit; 
+}
+
+#ifndef _WIN32
+
+//identity of the source file, the entry name is a hash of it: 
+struct SourceIdentity{
+    std::string key; 
+    uint64_t size; 
+    int64_t seconds; 
+    int64_t nanoseconds; 
+}; 
+
+static int64_t ModificationNanoseconds(const struct stat& fileStat)
+{
+#if defined(__APPLE__)
+    return static_cast<int64_t>(fileStat.st_mtimespec.tv_nsec); 
+#else
+    return static_cast<int64_t>(fileStat.st_mtim.tv_nsec); 
+#endif
+}
+
+static bool GetSourceIdentity(const std::string& sourcePath, uint32_t options, SourceIdentity& identity)
+{
+    char *absolutePath = realpath(sourcePath.c_str(), NULL); 
+    if(absolutePath == NULL){
+        return false; 
+    }
+    std::string path(absolutePath); 
+    free(absolutePath); 
+
+    struct stat sourceStat; 
+    if(stat(path.c_str(), &sourceStat) != 0 || !S_ISREG(sourceStat.st_mode)){
+        return false; 
+    }
+
+    identity.size = static_cast<uint64_t>(sourceStat.st_size); 
+    identity.seconds = static_cast<int64_t>(sourceStat.st_mtime); 
+    identity.nanoseconds = ModificationNanoseconds(sourceStat); 
+
+    std::ostringstream key; 
+    key << path << '|' << identity.size << '|' << identity.seconds << '.' << identity.nanoseconds << '|' << options; 
+    identity.key = key.str(); 
+    return true; 
+}
+
+static std::string EntryPath(const std::string& directory, const std::string& key)
+{
+    //FNV-1a, the full key is stored in the entry and compared on load: 
+    uint64_t hash = 14695981039346656037ULL; 
+    for(size_t idx = 0; idx < key.size(); ++idx){
+        hash ^= static_cast<unsigned char>(key[idx]); 
+        hash *= 1099511628211ULL; 
+    }
+
+    std::ostringstream path; 
+    path << directory << '/' << std::hex << std::setw(16) << std::setfill('0') << hash << cacheSuffix; 
+    return path.str(); 
+}
+
+static bool EndsWith(const std::string& name, const std::string& suffix)
+{
+    return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0; 
+}
+
+//remove least recently used entries (by modification time, refreshed on load) until the directory fits. 
+//keepPath, the entry just written, is never removed: 
+static void TrimVolumeCache(const std::string& directory, uint64_t limit, const std::string& keepPath)
+{
+    struct CacheFile{
+        std::string path; 
+        uint64_t size; 
+        int64_t lastUse; 
+        bool operator<(const CacheFile& other) const{ return lastUse < other.lastUse; }
+    }; 
+
+    DIR *dir = opendir(directory.c_str()); 
+    if(dir == NULL){
+        return; 
+    }
+
+    std::vector<CacheFile> entries; 
+    uint64_t totalSize = 0; 
+    time_t now = time(NULL); 
+    for(struct dirent *item = readdir(dir); item != NULL; item = readdir(dir)){
+        std::string name(item->d_name); 
+        bool isEntry = EndsWith(name, cacheSuffix); 
+        bool isTemporary = EndsWith(name, ".tmp") && name.find(cacheSuffix) != std::string::npos; 
+        if(!isEntry && !isTemporary){
+            continue; 
+        }
+
+        CacheFile entry; 
+        entry.path = directory + "/" + name; 
+        struct stat entryStat; 
+        if(stat(entry.path.c_str(), &entryStat) != 0){
+            continue; 
+        }
+        if(isTemporary){
+            if(now - entryStat.st_mtime > staleTemporaryAge){
+                unlink(entry.path.c_str()); 
+            }
+            continue; 
+        }
+        entry.size = static_cast<uint64_t>(entryStat.st_size); 
+        entry.lastUse = static_cast<int64_t>(entryStat.st_mtime) * 1000000000 + ModificationNanoseconds(entryStat); 
+        entries.push_back(entry); 
+        totalSize += entry.size; 
+    }
+    closedir(dir); 
+
+    //other processes may map removed entries, their mappings stay valid: 
+    std::sort(entries.begin(), entries.end()); 
+    for(size_t idx = 0; idx < entries.size() && totalSize > limit; ++idx){
+        if(entries[idx].path == keepPath){
+            continue; 
+        }
+        unlink(entries[idx].path.c_str()); 
+        totalSize -= entries[idx].size; 
+    }
+}
+
+bool LoadCachedVolume(const std::string& sourcePath, uint32_t options, CachedVolumeHeader& header, VolumeView& view)
+{
+    std::string directory = GetVolumeCacheDirectory(); 
+    SourceIdentity identity; 
+    if(directory.empty() || !GetSourceIdentity(sourcePath, options, identity)){
+        return false; 
+    }
+
+    std::string entryPath = EntryPath(directory, identity.key); 
+    std::shared_ptr<Utilities::MappedFile> mappedFile(new Utilities::MappedFile); 
+    if(!mappedFile->Open(entryPath) || mappedFile->Size() < sizeof(CacheEntryHeader)){
+        return false; 
+    }
+
+    //anything that does not match exactly is a miss, the entry is rewritten after decoding: 
+    CacheEntryHeader entry; 
+    std::memcpy(&entry, mappedFile->Data(), sizeof(entry)); 
+    if(std::memcmp(entry.magic, cacheMagic, sizeof(cacheMagic)) != 0 || entry.byteOrder != cacheByteOrder){
+        return false; 
+    }
+    if(entry.keyLength != identity.key.size() || 
+        sizeof(entry) + entry.keyLength > entry.dataOffset || 
+        entry.dataOffset % cacheAlignment != 0 || 
+        entry.dataOffset + entry.dataLength != mappedFile->Size() || 
+        std::memcmp(mappedFile->Data() + sizeof(entry), identity.key.data(), entry.keyLength) != 0){
+        return false; 
+    }
+    if(entry.sourceSize != identity.size || entry.sourceSeconds != identity.seconds || 
+        entry.sourceNanoseconds != identity.nanoseconds || entry.options != options){
+        return false; 
+    }
+
+    uint64_t numVoxels = 1; 
+    for(int axis = 0; axis < 4; ++axis){
+        if(entry.dim[axis] <= 0){
+            return false; 
+        }
+        numVoxels *= static_cast<uint64_t>(entry.dim[axis]); 
+    }
+    if(numVoxels * sizeof(float) != entry.dataLength){
+        return false; 
+    }
+
+    for(int axis = 0; axis < 3; ++axis){
+        header.dim[axis] = entry.dim[axis]; 
+        header.spacing[axis] = entry.spacing[axis]; 
+        header.origin[axis] = entry.origin[axis]; 
+    }
+    header.numberOfVolumes = entry.dim[3]; 
+
+    view = VolumeView(); 
+    view.type = VOXEL_FLOAT32; 
+    view.stride[0] = sizeof(float); 
+    for(int axis = 0; axis < 4; ++axis){
+        view.dim[axis] = entry.dim[axis]; 
+        if(axis > 0){
+            view.stride[axis] = view.stride[axis - 1] * entry.dim[axis - 1]; 
+        }
+    }
+    view.data = mappedFile->Data() + entry.dataOffset; 
+    view.owner = mappedFile; 
+
+    //mark the entry as recently used: 
+    utime(entryPath.c_str(), NULL); 
+    return true; 
+}
+
+bool StoreCachedVolume(const std::string& sourcePath, uint32_t options, const CachedVolumeHeader& header, const float* voxels)
+{
+    std::string directory = GetVolumeCacheDirectory(); 
+    uint64_t limit = GetVolumeCacheLimit(); 
+    SourceIdentity identity; 
+    if(directory.empty() || voxels == NULL || !GetSourceIdentity(sourcePath, options, identity)){
+        return false; 
+    }
+
+    CacheEntryHeader entry; 
+    std::memset(&entry, 0, sizeof(entry)); 
+    std::memcpy(entry.magic, cacheMagic, sizeof(cacheMagic)); 
+    entry.byteOrder = cacheByteOrder; 
+    entry.keyLength = static_cast<uint32_t>(identity.key.size()); 
+    entry.dataOffset = (sizeof(entry) + identity.key.size() + cacheAlignment - 1) / cacheAlignment * cacheAlignment; 
+    entry.sourceSize = identity.size; 
+    entry.sourceSeconds = identity.seconds; 
+    entry.sourceNanoseconds = identity.nanoseconds; 
+    entry.options = options; 
+
+    uint64_t numVoxels = 1; 
+    for(int axis = 0; axis < 3; ++axis){
+        entry.dim[axis] = header.dim[axis]; 
+        entry.spacing[axis] = header.spacing[axis]; 
+        entry.origin[axis] = header.origin[axis]; 
+    }
+    entry.dim[3] = header.numberOfVolumes; 
+    for(int axis = 0; axis < 4; ++axis){
+        if(entry.dim[axis] <= 0){
+            return false; 
+        }
+        numVoxels *= static_cast<uint64_t>(entry.dim[axis]); 
+    }
+    entry.dataLength = numVoxels * sizeof(float); 
+    if(entry.dataOffset + entry.dataLength > limit){
+        return false; 
+    }
+
+    //written next to the entry and renamed, concurrent writers of the same entry write the same bytes. 
+    //the temporary name is unique to the process and to this write, threads may store the same entry: 
+    std::string entryPath = EntryPath(directory, identity.key); 
+    std::ostringstream temporaryPath; 
+    temporaryPath << entryPath << '.' << getpid() << '.' << temporaryCounter++ << ".tmp"; 
+
+    FILE *file = fopen(temporaryPath.str().c_str(), "wb"); 
+    if(file == NULL){
+        std::cout << "Volume cache: " << temporaryPath.str() << ", failed to open. " << std::endl; 
+        return false; 
+    }
+    std::vector<char> padding(entry.dataOffset - sizeof(entry) - identity.key.size(), 0); 
+    bool isWritten = 
+        fwrite(&entry, sizeof(entry), 1, file) == 1 && 
+        fwrite(identity.key.data(), 1, identity.key.size(), file) == identity.key.size() && 
+        fwrite(padding.data(), 1, padding.size(), file) == padding.size() && 
+        fwrite(voxels, sizeof(float), numVoxels, file) == numVoxels; 
+    isWritten = (fclose(file) == 0) && isWritten; 
+
+    if(!isWritten || rename(temporaryPath.str().c_str(), entryPath.c_str()) != 0){
+        std::cout << "Volume cache: " << entryPath << ", failed to write. " << std::endl; 
+        remove(temporaryPath.str().c_str()); 
+        return false; 
+    }
+
+    TrimVolumeCache(directory, limit, entryPath); 
+    return true; 
+}
+
+#else
+
+bool LoadCachedVolume(const std::string& sourcePath, uint32_t options, CachedVolumeHeader& header, VolumeView& view)
+{
+    return false; 
+}
+
+bool StoreCachedVolume(const std::string& sourcePath, uint32_t options, const CachedVolumeHeader& header, const float* voxels)
+{
+    return false; 
+}
+
+#endif
+
+}
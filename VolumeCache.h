@@ -0,0 +1,46 @@
+#ifndef VOLUMECACHE
+#define VOLUMECACHE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "MedImgParser.h"
+
+namespace MedImageParser
+{
+
+/* ------------------------------ Decoded volume cache ---------------------------- */ 
+//Float volumes as returned by MedicalImageIO::Read(), kept in a directory shared by processes. 
+//Entries are keyed by the source path, size, modification time and the read options, 
+//so a changed source file is never served stale, its old entry just ages out. 
+//Each entry is one self-describing file (header, then the float voxels page aligned)
+//that is memory mapped on load. Entries are written to a temporary file and renamed, 
+//readers never see partial files. The least recently used entries are removed once the
+//directory grows past its limit. 
+
+//geometry stored with the voxels: 
+struct CachedVolumeHeader{
+    int dim[3]; 
+    int numberOfVolumes; 
+    float spacing[3]; 
+    float origin[3]; 
+}; 
+
+//empty directory (the default) disables the cache, the directory must exist: 
+void SetVolumeCacheDirectory(const std::string& directory); 
+std::string GetVolumeCacheDirectory(); 
+bool VolumeCacheEnabled(); 
+
+//bytes of entries kept in the directory (16 GB by default): 
+void SetVolumeCacheLimit(uint64_t bytes); 
+uint64_t GetVolumeCacheLimit(); 
+
+//options: read options the float values depend on, e.g. intensity scaling. 
+//view is a float32 view on the mapped entry: 
+bool LoadCachedVolume(const std::string& sourcePath, uint32_t options, CachedVolumeHeader& header, VolumeView& view); 
+bool StoreCachedVolume(const std::string& sourcePath, uint32_t options, const CachedVolumeHeader& header, const float* voxels); 
+
+}
+
+#endif
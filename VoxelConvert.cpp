@@ -0,0 +1,593 @@
+#include "VoxelConvert.h"
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VOXELCONVERT_X86
+#include <immintrin.h>
+#endif
+
+namespace MedImageParser
+{
+
+/* ------------------------------ Scalar kernels ---------------------------- */ 
+template<typename T>
+static inline T LoadVoxel(const unsigned char* input, bool byteSwapped)
+{
+    T voxel; 
+    if(byteSwapped){
+        unsigned char bytes[sizeof(T)]; 
+        for(size_t idx = 0; idx < sizeof(T); ++idx){
+            bytes[idx] = input[sizeof(T) - 1 - idx]; 
+        }
+        std::memcpy(&voxel, bytes, sizeof(T)); 
+    }
+    else{
+        std::memcpy(&voxel, input, sizeof(T)); 
+    }
+    return voxel; 
+}
+
+//drops the unusedBits high bits, sign extending signed voxels from the highest stored bit: 
+template<typename T>
+static inline T KeepStoredBits(T voxel, int unusedBits)
+{
+    typedef typename std::make_unsigned<T>::type UnsignedT; 
+    return static_cast<T>(static_cast<T>(static_cast<UnsignedT>(static_cast<UnsignedT>(voxel) << unusedBits)) >> unusedBits); 
+}
+
+static inline float KeepStoredBits(float voxel, int)
+{
+    return voxel; 
+}
+
+static inline double KeepStoredBits(double voxel, int)
+{
+    return voxel; 
+}
+
+//32 bit integers do not fit a float, they are rescaled in double and rounded once: 
+template<typename T>
+struct RescalesInDouble{
+    static const bool value = std::is_integral<T>::value && sizeof(T) == 4; 
+}; 
+
+//reference for the vector kernels and their tails, same rounding in every path: 
+template<typename T>
+static void ScalarRow(const unsigned char* input, size_t count, bool byteSwapped, int unusedBits, bool scaled, float slope, float intercept, float* output)
+{
+    for(size_t idx = 0; idx < count; ++idx){
+        T voxel = LoadVoxel<T>(input + idx * sizeof(T), byteSwapped); 
+        if(unusedBits > 0){
+            voxel = KeepStoredBits(voxel, unusedBits); 
+        }
+        if(scaled && RescalesInDouble<T>::value){
+            output[idx] = static_cast<float>(static_cast<double>(voxel) * slope + intercept); 
+            continue; 
+        }
+        float value = static_cast<float>(voxel); 
+        output[idx] = scaled ? value * slope + intercept : value; 
+    }
+}
+
+static void ConvertRowScalar(VoxelType type, const unsigned char* input, size_t count, bool byteSwapped, int unusedBits, bool scaled, float slope, float intercept, float* output)
+{
+    switch (type)
+    {
+    case VOXEL_UINT8: ScalarRow<uint8_t>(input, count, false, unusedBits, scaled, slope, intercept, output); break; 
+    case VOXEL_INT8: ScalarRow<int8_t>(input, count, false, unusedBits, scaled, slope, intercept, output); break; 
+    case VOXEL_UINT16: ScalarRow<uint16_t>(input, count, byteSwapped, unusedBits, scaled, slope, intercept, output); break; 
+    case VOXEL_INT16: ScalarRow<int16_t>(input, count, byteSwapped, unusedBits, scaled, slope, intercept, output); break; 
+    case VOXEL_UINT32: ScalarRow<uint32_t>(input, count, byteSwapped, unusedBits, scaled, slope, intercept, output); break; 
+    case VOXEL_INT32: ScalarRow<int32_t>(input, count, byteSwapped, unusedBits, scaled, slope, intercept, output); break; 
+    case VOXEL_FLOAT32: ScalarRow<float>(input, count, byteSwapped, 0, scaled, slope, intercept, output); break; 
+    case VOXEL_FLOAT64: ScalarRow<double>(input, count, byteSwapped, 0, scaled, slope, intercept, output); break; 
+    default: break; 
+    }
+}
+
+#ifdef VOXELCONVERT_X86
+/* ------------------------------ SSE2 kernels ---------------------------- */ 
+//4 floats per step, byte swaps with shifts since SSE2 has no byte shuffle: 
+#define SSE2_TARGET __attribute__((target("sse2")))
+
+SSE2_TARGET static inline __m128i Swap16SSE2(__m128i value)
+{
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8)); 
+}
+
+SSE2_TARGET static inline __m128i Swap32SSE2(__m128i value)
+{
+    value = Swap16SSE2(value); 
+    return _mm_or_si128(_mm_slli_epi32(value, 16), _mm_srli_epi32(value, 16)); 
+}
+
+//exact for the full unsigned range, the halves convert exactly and round once when added: 
+SSE2_TARGET static inline __m128 Uint32ToFloatSSE2(__m128i value)
+{
+    __m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(value, 16)); 
+    __m128 low = _mm_cvtepi32_ps(_mm_and_si128(value, _mm_set1_epi32(0xffff))); 
+    return _mm_add_ps(_mm_mul_ps(high, _mm_set1_ps(65536.0f)), low); 
+}
+
+SSE2_TARGET static inline void StoreSSE2(float* output, __m128 value, bool scaled, __m128 slope, __m128 intercept)
+{
+    if(scaled){
+        value = _mm_add_ps(_mm_mul_ps(value, slope), intercept); 
+    }
+    _mm_storeu_ps(output, value); 
+}
+
+//32 bit integers rescaled in double, unsigned ones offset into the signed range and back: 
+SSE2_TARGET static inline __m128d RescaleInt32SSE2(__m128i words, bool isSigned, __m128d slope, __m128d intercept)
+{
+    __m128d value = _mm_cvtepi32_pd(words); 
+    if(!isSigned){
+        value = _mm_add_pd(value, _mm_set1_pd(2147483648.0)); 
+    }
+    return _mm_add_pd(_mm_mul_pd(value, slope), intercept); 
+}
+
+SSE2_TARGET static inline void StoreInt32SSE2(float* output, __m128i words, bool isSigned, __m128d slope, __m128d intercept)
+{
+    if(!isSigned){
+        words = _mm_xor_si128(words, _mm_set1_epi32(static_cast<int>(0x80000000u))); 
+    }
+    __m128 low = _mm_cvtpd_ps(RescaleInt32SSE2(words, isSigned, slope, intercept)); 
+    __m128 high = _mm_cvtpd_ps(RescaleInt32SSE2(_mm_shuffle_epi32(words, _MM_SHUFFLE(1, 0, 3, 2)), isSigned, slope, intercept)); 
+    _mm_storeu_ps(output, _mm_movelh_ps(low, high)); 
+}
+
+//high bits above the stored ones shifted out, back down with the sign for signed voxels: 
+SSE2_TARGET static inline __m128i KeepStoredBits16SSE2(__m128i value, int unusedBits, bool isSigned)
+{
+    value = _mm_slli_epi16(value, unusedBits); 
+    return isSigned ? _mm_srai_epi16(value, unusedBits) : _mm_srli_epi16(value, unusedBits); 
+}
+
+SSE2_TARGET static inline __m128i KeepStoredBits32SSE2(__m128i value, int unusedBits, bool isSigned)
+{
+    value = _mm_slli_epi32(value, unusedBits); 
+    return isSigned ? _mm_srai_epi32(value, unusedBits) : _mm_srli_epi32(value, unusedBits); 
+}
+
+SSE2_TARGET static size_t ConvertRowSSE2(VoxelType type, const unsigned char* input, size_t count, bool byteSwapped, int unusedBits, bool scaled, float slope, float intercept, float* output)
+{
+    const __m128 slopes = _mm_set1_ps(slope); 
+    const __m128 intercepts = _mm_set1_ps(intercept); 
+    const __m128d slopesDouble = _mm_set1_pd(slope); 
+    const __m128d interceptsDouble = _mm_set1_pd(intercept); 
+    const __m128i zero = _mm_setzero_si128(); 
+    size_t idx = 0; 
+
+    switch (type)
+    {
+    case VOXEL_UINT8:
+    case VOXEL_INT8:
+        //fewer than 8 stored bits are left to the scalar tail: 
+        for(; unusedBits == 0 && idx + 16 <= count; idx += 16){
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + idx)); 
+            __m128i words[2]; 
+            if(type == VOXEL_INT8){
+                words[0] = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8); 
+                words[1] = _mm_srai_epi16(_mm_unpackhi_epi8(bytes, bytes), 8); 
+            }
+            else{
+                words[0] = _mm_unpacklo_epi8(bytes, zero); 
+                words[1] = _mm_unpackhi_epi8(bytes, zero); 
+            }
+            for(int half = 0; half < 2; ++half){
+                __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(words[half], words[half]), 16); 
+                __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(words[half], words[half]), 16); 
+                StoreSSE2(output + idx + half * 8, _mm_cvtepi32_ps(low), scaled, slopes, intercepts); 
+                StoreSSE2(output + idx + half * 8 + 4, _mm_cvtepi32_ps(high), scaled, slopes, intercepts); 
+            }
+        }
+        break; 
+
+    case VOXEL_UINT16:
+    case VOXEL_INT16:
+        for(; idx + 8 <= count; idx += 8){
+            __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + idx * 2)); 
+            if(byteSwapped){
+                words = Swap16SSE2(words); 
+            }
+            if(unusedBits > 0){
+                words = KeepStoredBits16SSE2(words, unusedBits, type == VOXEL_INT16); 
+            }
+            __m128i low, high; 
+            if(type == VOXEL_INT16){
+                low = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16); 
+                high = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16); 
+            }
+            else{
+                low = _mm_unpacklo_epi16(words, zero); 
+                high = _mm_unpackhi_epi16(words, zero); 
+            }
+            StoreSSE2(output + idx, _mm_cvtepi32_ps(low), scaled, slopes, intercepts); 
+            StoreSSE2(output + idx + 4, _mm_cvtepi32_ps(high), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_UINT32:
+    case VOXEL_INT32:
+    case VOXEL_FLOAT32:
+        for(; idx + 4 <= count; idx += 4){
+            __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + idx * 4)); 
+            if(byteSwapped){
+                words = Swap32SSE2(words); 
+            }
+            if(unusedBits > 0){
+                words = KeepStoredBits32SSE2(words, unusedBits, type == VOXEL_INT32); 
+            }
+            if(scaled && type != VOXEL_FLOAT32){
+                StoreInt32SSE2(output + idx, words, type == VOXEL_INT32, slopesDouble, interceptsDouble); 
+                continue; 
+            }
+            __m128 value; 
+            if(type == VOXEL_FLOAT32){
+                value = _mm_castsi128_ps(words); 
+            }
+            else if(type == VOXEL_INT32){
+                value = _mm_cvtepi32_ps(words); 
+            }
+            else{
+                value = Uint32ToFloatSSE2(words); 
+            }
+            StoreSSE2(output + idx, value, scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_FLOAT64:
+        //swapped doubles are left to the scalar tail: 
+        for(; !byteSwapped && idx + 4 <= count; idx += 4){
+            __m128 low = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(input + idx * 8))); 
+            __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(input + idx * 8 + 16))); 
+            StoreSSE2(output + idx, _mm_movelh_ps(low, high), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    default:
+        break; 
+    }
+
+    return idx; 
+}
+
+/* ------------------------------ AVX2 kernels ---------------------------- */ 
+//8 floats per step, widening loads and byte shuffles: 
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET static inline void StoreAVX2(float* output, __m256 value, bool scaled, __m256 slope, __m256 intercept)
+{
+    if(scaled){
+        value = _mm256_add_ps(_mm256_mul_ps(value, slope), intercept); 
+    }
+    _mm256_storeu_ps(output, value); 
+}
+
+AVX2_TARGET static inline __m256 Uint32ToFloatAVX2(__m256i value)
+{
+    __m256 high = _mm256_cvtepi32_ps(_mm256_srli_epi32(value, 16)); 
+    __m256 low = _mm256_cvtepi32_ps(_mm256_and_si256(value, _mm256_set1_epi32(0xffff))); 
+    return _mm256_add_ps(_mm256_mul_ps(high, _mm256_set1_ps(65536.0f)), low); 
+}
+
+AVX2_TARGET static inline __m128 RescaleInt32AVX2(__m128i words, bool isSigned, __m256d slope, __m256d intercept)
+{
+    __m256d value = _mm256_cvtepi32_pd(words); 
+    if(!isSigned){
+        value = _mm256_add_pd(value, _mm256_set1_pd(2147483648.0)); 
+    }
+    return _mm256_cvtpd_ps(_mm256_add_pd(_mm256_mul_pd(value, slope), intercept)); 
+}
+
+//32 bit integers rescaled in double, unsigned ones offset into the signed range and back: 
+AVX2_TARGET static inline void StoreInt32AVX2(float* output, __m256i words, bool isSigned, __m256d slope, __m256d intercept)
+{
+    if(!isSigned){
+        words = _mm256_xor_si256(words, _mm256_set1_epi32(static_cast<int>(0x80000000u))); 
+    }
+    __m128 low = RescaleInt32AVX2(_mm256_castsi256_si128(words), isSigned, slope, intercept); 
+    __m128 high = RescaleInt32AVX2(_mm256_extracti128_si256(words, 1), isSigned, slope, intercept); 
+    _mm256_storeu_ps(output, _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1)); 
+}
+
+AVX2_TARGET static size_t ConvertRowAVX2(VoxelType type, const unsigned char* input, size_t count, bool byteSwapped, int unusedBits, bool scaled, float slope, float intercept, float* output)
+{
+    const __m256 slopes = _mm256_set1_ps(slope); 
+    const __m256 intercepts = _mm256_set1_ps(intercept); 
+    const __m256d slopesDouble = _mm256_set1_pd(slope); 
+    const __m256d interceptsDouble = _mm256_set1_pd(intercept); 
+    const __m128i swap16 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14); 
+    const __m256i swap32 = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12); 
+    size_t idx = 0; 
+
+    switch (type)
+    {
+    case VOXEL_UINT8:
+        for(; unusedBits == 0 && idx + 8 <= count; idx += 8){
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + idx)); 
+            StoreAVX2(output + idx, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_INT8:
+        for(; unusedBits == 0 && idx + 8 <= count; idx += 8){
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + idx)); 
+            StoreAVX2(output + idx, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(bytes)), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_UINT16:
+    case VOXEL_INT16:
+        for(; idx + 8 <= count; idx += 8){
+            __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + idx * 2)); 
+            if(byteSwapped){
+                words = _mm_shuffle_epi8(words, swap16); 
+            }
+            if(unusedBits > 0){
+                words = KeepStoredBits16SSE2(words, unusedBits, type == VOXEL_INT16); 
+            }
+            __m256i value = (type == VOXEL_INT16) ? _mm256_cvtepi16_epi32(words) : _mm256_cvtepu16_epi32(words); 
+            StoreAVX2(output + idx, _mm256_cvtepi32_ps(value), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_UINT32:
+    case VOXEL_INT32:
+    case VOXEL_FLOAT32:
+        for(; idx + 8 <= count; idx += 8){
+            __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + idx * 4)); 
+            if(byteSwapped){
+                words = _mm256_shuffle_epi8(words, swap32); 
+            }
+            if(unusedBits > 0){
+                words = _mm256_slli_epi32(words, unusedBits); 
+                words = (type == VOXEL_INT32) ? _mm256_srai_epi32(words, unusedBits) : _mm256_srli_epi32(words, unusedBits); 
+            }
+            if(scaled && type != VOXEL_FLOAT32){
+                StoreInt32AVX2(output + idx, words, type == VOXEL_INT32, slopesDouble, interceptsDouble); 
+                continue; 
+            }
+            __m256 value; 
+            if(type == VOXEL_FLOAT32){
+                value = _mm256_castsi256_ps(words); 
+            }
+            else if(type == VOXEL_INT32){
+                value = _mm256_cvtepi32_ps(words); 
+            }
+            else{
+                value = Uint32ToFloatAVX2(words); 
+            }
+            StoreAVX2(output + idx, value, scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_FLOAT64:
+        for(; !byteSwapped && idx + 8 <= count; idx += 8){
+            __m128 low = _mm256_cvtpd_ps(_mm256_loadu_pd(reinterpret_cast<const double*>(input + idx * 8))); 
+            __m128 high = _mm256_cvtpd_ps(_mm256_loadu_pd(reinterpret_cast<const double*>(input + idx * 8 + 32))); 
+            StoreAVX2(output + idx, _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    default:
+        break; 
+    }
+
+    return idx; 
+}
+
+/* ------------------------------ AVX-512 kernels ---------------------------- */ 
+//16 floats per step, AVX-512BW for the byte shuffles: 
+#define AVX512_TARGET __attribute__((target("avx512f,avx512bw")))
+
+//GCC flags the undefined pass-through operand inside its own avx512fintrin.h wrappers: 
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+AVX512_TARGET static inline void StoreAVX512(float* output, __m512 value, bool scaled, __m512 slope, __m512 intercept)
+{
+    if(scaled){
+        value = _mm512_add_ps(_mm512_mul_ps(value, slope), intercept); 
+    }
+    _mm512_storeu_ps(output, value); 
+}
+
+AVX512_TARGET static inline __m256 RescaleInt32AVX512(__m256i words, bool isSigned, __m512d slope, __m512d intercept)
+{
+    __m512d value = isSigned ? _mm512_cvtepi32_pd(words) : _mm512_cvtepu32_pd(words); 
+    return _mm512_cvtpd_ps(_mm512_add_pd(_mm512_mul_pd(value, slope), intercept)); 
+}
+
+//32 bit integers rescaled in double: 
+AVX512_TARGET static inline void StoreInt32AVX512(float* output, __m512i words, bool isSigned, __m512d slope, __m512d intercept)
+{
+    __m256 low = RescaleInt32AVX512(_mm512_castsi512_si256(words), isSigned, slope, intercept); 
+    __m256 high = RescaleInt32AVX512(_mm512_extracti64x4_epi64(words, 1), isSigned, slope, intercept); 
+    _mm512_storeu_ps(output, _mm512_castpd_ps(_mm512_insertf64x4(
+        _mm512_castpd256_pd512(_mm256_castps_pd(low)), _mm256_castps_pd(high), 1))); 
+}
+
+AVX512_TARGET static size_t ConvertRowAVX512(VoxelType type, const unsigned char* input, size_t count, bool byteSwapped, int unusedBits, bool scaled, float slope, float intercept, float* output)
+{
+    const __m512 slopes = _mm512_set1_ps(slope); 
+    const __m512 intercepts = _mm512_set1_ps(intercept); 
+    const __m512d slopesDouble = _mm512_set1_pd(slope); 
+    const __m512d interceptsDouble = _mm512_set1_pd(intercept); 
+    const __m256i swap16 = _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14); 
+    const __m512i swap32 = _mm512_broadcast_i32x4(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)); 
+    size_t idx = 0; 
+
+    switch (type)
+    {
+    case VOXEL_UINT8:
+        for(; unusedBits == 0 && idx + 16 <= count; idx += 16){
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + idx)); 
+            StoreAVX512(output + idx, _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes)), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_INT8:
+        for(; unusedBits == 0 && idx + 16 <= count; idx += 16){
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + idx)); 
+            StoreAVX512(output + idx, _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(bytes)), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_UINT16:
+    case VOXEL_INT16:
+        for(; idx + 16 <= count; idx += 16){
+            __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + idx * 2)); 
+            if(byteSwapped){
+                words = _mm256_shuffle_epi8(words, swap16); 
+            }
+            if(unusedBits > 0){
+                words = _mm256_slli_epi16(words, unusedBits); 
+                words = (type == VOXEL_INT16) ? _mm256_srai_epi16(words, unusedBits) : _mm256_srli_epi16(words, unusedBits); 
+            }
+            __m512i value = (type == VOXEL_INT16) ? _mm512_cvtepi16_epi32(words) : _mm512_cvtepu16_epi32(words); 
+            StoreAVX512(output + idx, _mm512_cvtepi32_ps(value), scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_UINT32:
+    case VOXEL_INT32:
+    case VOXEL_FLOAT32:
+        for(; idx + 16 <= count; idx += 16){
+            __m512i words = _mm512_loadu_si512(input + idx * 4); 
+            if(byteSwapped){
+                words = _mm512_shuffle_epi8(words, swap32); 
+            }
+            if(unusedBits > 0){
+                words = _mm512_slli_epi32(words, unusedBits); 
+                words = (type == VOXEL_INT32) ? _mm512_srai_epi32(words, unusedBits) : _mm512_srli_epi32(words, unusedBits); 
+            }
+            if(scaled && type != VOXEL_FLOAT32){
+                StoreInt32AVX512(output + idx, words, type == VOXEL_INT32, slopesDouble, interceptsDouble); 
+                continue; 
+            }
+            __m512 value; 
+            if(type == VOXEL_FLOAT32){
+                value = _mm512_castsi512_ps(words); 
+            }
+            else if(type == VOXEL_INT32){
+                value = _mm512_cvtepi32_ps(words); 
+            }
+            else{
+                value = _mm512_cvtepu32_ps(words); 
+            }
+            StoreAVX512(output + idx, value, scaled, slopes, intercepts); 
+        }
+        break; 
+
+    case VOXEL_FLOAT64:
+        for(; !byteSwapped && idx + 16 <= count; idx += 16){
+            __m256 low = _mm512_cvtpd_ps(_mm512_loadu_pd(input + idx * 8)); 
+            __m256 high = _mm512_cvtpd_ps(_mm512_loadu_pd(input + idx * 8 + 64)); 
+            __m512 value = _mm512_castpd_ps(_mm512_insertf64x4(
+                _mm512_castpd256_pd512(_mm256_castps_pd(low)), _mm256_castps_pd(high), 1)); 
+            StoreAVX512(output + idx, value, scaled, slopes, intercepts); 
+        }
+        break; 
+
+    default:
+        break; 
+    }
+
+    return idx; 
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+/* ------------------------------ Dispatch ---------------------------- */ 
+SimdLevel DetectSimdLevel()
+{
+#ifdef VOXELCONVERT_X86
+    __builtin_cpu_init(); 
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")){
+        return SIMD_AVX512; 
+    }
+    if(__builtin_cpu_supports("avx2")){
+        return SIMD_AVX2; 
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return SIMD_SSE2; 
+    }
+#endif
+    return SIMD_SCALAR; 
+}
+
+//-1 until the first conversion or SetSimdLevel(): 
+static std::atomic<int> activeSimdLevel(-1); 
+
+SimdLevel GetSimdLevel()
+{
+    int level = activeSimdLevel.load(); 
+    if(level < 0){
+        level = DetectSimdLevel(); 
+        activeSimdLevel = level; 
+    }
+    return static_cast<SimdLevel>(level); 
+}
+
+void SetSimdLevel(SimdLevel level)
+{
+    activeSimdLevel = std::min(level, DetectSimdLevel()); 
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SIMD_SSE2: return "SSE2"; 
+    case SIMD_AVX2: return "AVX2"; 
+    case SIMD_AVX512: return "AVX-512"; 
+    default: return "scalar"; 
+    }
+}
+
+void ConvertVoxelRow(
+    VoxelType type, const unsigned char* input, size_t count, 
+    bool byteSwapped, float slope, float intercept, float* output, 
+    int bitsStored)
+{
+    bool scaled = (slope != 1.0f || intercept != 0.0f); 
+    byteSwapped = byteSwapped && VoxelTypeSize(type) > 1; 
+
+    //float voxels use all of their bits: 
+    int voxelBits = static_cast<int>(VoxelTypeSize(type)) * 8; 
+    bool isInteger = (type != VOXEL_FLOAT32 && type != VOXEL_FLOAT64); 
+    int unusedBits = (isInteger && bitsStored > 0 && bitsStored < voxelBits) ? voxelBits - bitsStored : 0; 
+
+    //the vector kernels stop at their last full step, the scalar kernel finishes the row: 
+    size_t done = 0; 
+#ifdef VOXELCONVERT_X86
+    switch (GetSimdLevel())
+    {
+    case SIMD_AVX512: done = ConvertRowAVX512(type, input, count, byteSwapped, unusedBits, scaled, slope, intercept, output); break; 
+    case SIMD_AVX2: done = ConvertRowAVX2(type, input, count, byteSwapped, unusedBits, scaled, slope, intercept, output); break; 
+    case SIMD_SSE2: done = ConvertRowSSE2(type, input, count, byteSwapped, unusedBits, scaled, slope, intercept, output); break; 
+    default: break; 
+    }
+#endif
+
+    size_t voxelBytes = VoxelTypeSize(type); 
+    ConvertRowScalar(type, input + done * voxelBytes, count - done, byteSwapped, unusedBits, scaled, slope, intercept, output + done); 
+}
+
+}
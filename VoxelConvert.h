@@ -0,0 +1,39 @@
+#ifndef VOXELCONVERT
+#define VOXELCONVERT
+
+#include <cstddef>
+
+#include "MedImgParser.h"
+
+namespace MedImageParser
+{
+
+/* ------------------------------ Voxel to float conversion ---------------------------- */ 
+//Instruction sets of the conversion kernels, picked at runtime: 
+enum SimdLevel{
+    SIMD_SCALAR = 0, 
+    SIMD_SSE2, 
+    SIMD_AVX2, 
+    SIMD_AVX512
+}; 
+
+//best level supported by the compiler and the CPU: 
+SimdLevel DetectSimdLevel(); 
+SimdLevel GetSimdLevel(); 
+//force a lower level, e.g. for comparisons, levels above DetectSimdLevel() are clamped: 
+void SetSimdLevel(SimdLevel level); 
+const char* SimdLevelName(SimdLevel level); 
+
+//Widen count packed voxels to float32: output = voxel * slope + intercept. 
+//byteSwapped voxels are swapped on the fly, the scaling is skipped for slope 1 and intercept 0. 
+//The scaling is single precision, except for 32 bit integer voxels: those are scaled in double 
+//and rounded to float once, since a float holds them exactly only up to 2^24. 
+//bitsStored > 0 keeps only the low bits of integer voxels (DICOM Bits Stored), sign extended for signed types: 
+void ConvertVoxelRow(
+    VoxelType type, const unsigned char* input, size_t count, 
+    bool byteSwapped, float slope, float intercept, float* output, 
+    int bitsStored = 0); 
+
+}
+
+#endif
@@ -23,6 +23,17 @@ NB: seeks for writable files with compression are quite restricted
 
 #include "znzlib.h"
 
+#ifdef HAVE_ZLIB
+#include "../zlib/gzindex.h"
+#if !defined(WIN32) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define ZNZ_HAVE_MMAP
+#endif
+#endif
+
 /*
 znzlib.c  (zipped or non-zipped library)
 
@@ -39,6 +50,113 @@ znzlib.c  (zipped or non-zipped library)
 */
 
 
+#ifdef HAVE_ZLIB
+/* Random access to gzip files opened for reading.
+
+   gzseek() can only move forward by inflating up to the target, and moves
+   backward by inflating again from the start of the file.  When a seek would
+   inflate more than GZINDEX_SPAN bytes, the file is switched (once) to reads
+   through an access point index of the gzip stream, so inflation restarts
+   at the closest access point instead.  The index is shared with the other
+   readers of the file in the process through the cache of gzindex.c (an
+   index recorded while the file was inflated in full is reused), loaded
+   from a sidecar file, or built by inflating the file once.  Sidecars only
+   persist indices across processes, see gzindex_set_sidecar_mode().
+*/
+
+/* load the compressed file contents into file->zdata */
+static int znz_load_zdata(znzFile file)
+{
+#ifdef ZNZ_HAVE_MMAP
+  struct stat st;
+  int fd = open(file->zpath, O_RDONLY);
+  void *data;
+
+  if( fd < 0 ) return -1;
+  if( fstat(fd, &st) != 0 || st.st_size <= 0 ){
+    close(fd);
+    return -1;
+  }
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if( data == MAP_FAILED ) return -1;
+  file->zdata = (unsigned char *)data;
+  file->zdata_len = (size_t)st.st_size;
+  file->zdata_mapped = 1;
+  return 0;
+#else
+  FILE *fp = fopen(file->zpath, "rb");
+  long len;
+
+  if( fp == NULL ) return -1;
+  if( fseek(fp, 0L, SEEK_END) != 0 || (len = ftell(fp)) <= 0 ||
+      fseek(fp, 0L, SEEK_SET) != 0 ){
+    fclose(fp);
+    return -1;
+  }
+  file->zdata = (unsigned char *)malloc((size_t)len);
+  if( file->zdata == NULL ||
+      fread(file->zdata, 1, (size_t)len, fp) != (size_t)len ){
+    free(file->zdata);
+    file->zdata = NULL;
+    fclose(fp);
+    return -1;
+  }
+  fclose(fp);
+  file->zdata_len = (size_t)len;
+  file->zdata_mapped = 0;
+  return 0;
+#endif
+}
+
+static void znz_free_zdata(znzFile file)
+{
+  if( file->zdata == NULL ) return;
+#ifdef ZNZ_HAVE_MMAP
+  if( file->zdata_mapped ) munmap(file->zdata, file->zdata_len);
+  else
+#endif
+  free(file->zdata);
+  file->zdata = NULL;
+  file->zdata_len = 0;
+}
+
+/* try to switch the file to indexed reads, return 1 on success */
+static int znz_use_index(znzFile file)
+{
+  gzindex *index = NULL;
+
+  if( file->zindex_tried ) return file->zreader != NULL;
+  file->zindex_tried = 1;
+  if( file->zpath == NULL ) return 0;
+  if( znz_load_zdata(file) != 0 ) return 0;
+
+  index = gzindex_cache_find(file->zpath, file->zdata_len);
+  if( index == NULL ){
+    if( gzindex_sidecar_load(file->zpath, file->zdata_len, &index) != Z_OK ){
+      /* BGZF members are indexed from their headers, others inflated */
+      index = NULL;
+      if( gzindex_build_bgzf(file->zdata, file->zdata_len, &index) != Z_OK &&
+          gzindex_build(file->zdata, file->zdata_len, GZINDEX_SPAN,
+                        NULL, 0, &index) != Z_OK ) index = NULL;
+      else gzindex_sidecar_save(file->zpath, index);
+    }
+    index = gzindex_cache_store(file->zpath, index);
+  }
+
+  if( index != NULL )
+    file->zreader = gzindex_open(file->zdata, file->zdata_len, index);
+  if( file->zreader == NULL ){
+    gzindex_cache_release(index);
+    znz_free_zdata(file);
+    return 0;
+  }
+  file->zindex = index;
+  return 1;
+}
+#endif
+
+
 /* Note extra argument (use_compression) where
    use_compression==0 is no compression
    use_compression!=0 uses zlib (gzip) compression
@@ -63,6 +181,9 @@ znzFile znzopen(const char *path, const char *mode, int use_compression)
     if((file->zfptr = gzopen(path,mode)) == NULL) {
         free(file);
         file = NULL;
+    } else if( mode[0] == 'r' && strchr(mode, '+') == NULL ) {
+        file->zpath = (char *)malloc(strlen(path) + 1);
+        if( file->zpath != NULL ) strcpy(file->zpath, path);
     }
   } else {
 #endif
@@ -114,6 +235,10 @@ int Xznzclose(znzFile * file)
   if (*file!=NULL) {
 #ifdef HAVE_ZLIB
     if ((*file)->zfptr!=NULL)  { retval = gzclose((*file)->zfptr); }
+    gzindex_close((*file)->zreader);
+    gzindex_cache_release((*file)->zindex);
+    znz_free_zdata(*file);
+    free((*file)->zpath);
 #endif
     if ((*file)->nzfptr!=NULL) { retval = fclose((*file)->nzfptr); }
 
@@ -137,6 +262,14 @@ size_t znzread(void* buf, size_t size, size_t nmemb, znzFile file)
 
   if (file==NULL) { return 0; }
 #ifdef HAVE_ZLIB
+  if (file->zreader!=NULL) {
+    long long nread_index = gzindex_read(file->zreader, (unsigned char *)buf, remain);
+    if( nread_index < 0 ) return 0;
+    remain -= (size_t)nread_index;
+    if( remain > 0 && remain < size )
+       fprintf(stderr,"** znzread: read short by %u bytes\n",(unsigned)remain);
+    return nmemb - remain/size;
+  }
   if (file->zfptr!=NULL) {
     /* gzread/write take unsigned int length, so maybe read in int pieces
        (noted by M Hanke, example given by M Adler)   6 July 2010 [rickr] */
@@ -200,6 +333,24 @@ long znzseek(znzFile file, long offset, int whence)
 {
   if (file==NULL) { return 0; }
 #ifdef HAVE_ZLIB
+  if (file->zfptr!=NULL && file->zreader==NULL && file->zpath!=NULL &&
+      whence!=SEEK_END) {
+    /* switch to indexed reads if gzseek would inflate too much */
+    long current = (long) gztell(file->zfptr);
+    long target = (whence==SEEK_CUR) ? current + offset : offset;
+    long cost = (target < current) ? target : target - current;
+    if( target >= 0 && cost > GZINDEX_SPAN && znz_use_index(file) )
+      gzindex_seek(file->zreader, (size_t)current);
+  }
+  if (file->zreader!=NULL) {
+    long target;
+    if( whence == SEEK_SET )      target = offset;
+    else if( whence == SEEK_CUR ) target = (long) gzindex_tell(file->zreader) + offset;
+    else                          target = (long) file->zindex->length + offset;
+    if( target < 0 ) return -1;
+    gzindex_seek(file->zreader, (size_t)target);
+    return target;
+  }
   if (file->zfptr!=NULL) return (long) gzseek(file->zfptr,offset,whence);
 #endif
   return fseek(file->nzfptr,offset,whence);
@@ -215,6 +366,10 @@ int znzrewind(znzFile stream)
      if (stream->zfptr!=NULL) return gzrewind(stream->zfptr);
   */
 
+  if (stream->zreader!=NULL) {
+    gzindex_seek(stream->zreader, 0);
+    return 0;
+  }
   if (stream->zfptr!=NULL) return (int)gzseek(stream->zfptr, 0L, SEEK_SET);
 #endif
   rewind(stream->nzfptr);
@@ -225,6 +380,7 @@ long znztell(znzFile file)
 {
   if (file==NULL) { return 0; }
 #ifdef HAVE_ZLIB
+  if (file->zreader!=NULL) return (long) gzindex_tell(file->zreader);
   if (file->zfptr!=NULL) return (long) gztell(file->zfptr);
 #endif
   return ftell(file->nzfptr);
@@ -244,6 +400,17 @@ char * znzgets(char* str, int size, znzFile file)
 {
   if (file==NULL) { return NULL; }
 #ifdef HAVE_ZLIB
+  if (file->zreader!=NULL) {
+    int n = 0;
+    unsigned char c;
+    if( size <= 0 ) return NULL;
+    while( n < size - 1 && gzindex_read(file->zreader, &c, 1) == 1 ) {
+      str[n++] = (char)c;
+      if( c == '\n' ) break;
+    }
+    str[n] = '\0';
+    return n > 0 ? str : NULL;
+  }
   if (file->zfptr!=NULL) return gzgets(file->zfptr,str,size);
 #endif
   return fgets(str,size,file->nzfptr);
@@ -264,6 +431,8 @@ int znzeof(znzFile file)
 {
   if (file==NULL) { return 0; }
 #ifdef HAVE_ZLIB
+  if (file->zreader!=NULL)
+    return gzindex_tell(file->zreader) >= file->zindex->length;
   if (file->zfptr!=NULL) return gzeof(file->zfptr);
 #endif
   return feof(file->nzfptr);
@@ -284,6 +453,10 @@ int znzgetc(znzFile file)
 {
   if (file==NULL) { return 0; }
 #ifdef HAVE_ZLIB
+  if (file->zreader!=NULL) {
+    unsigned char c;
+    return gzindex_read(file->zreader, &c, 1) == 1 ? (int)c : EOF;
+  }
   if (file->zfptr!=NULL) return gzgetc(file->zfptr);
 #endif
   return fgetc(file->nzfptr);
@@ -33,6 +33,13 @@ are required:
 
 NB: seeks for writable files with compression are quite restricted
 
+Long seeks in compressed files opened for reading use a random access
+index (see zlib/gzindex.h), so that inflation restarts close to the target
+instead of at the start of the file.  The index is built in memory on the
+first long seek into a file, unless the process already holds one or a
+<file>.gzidx sidecar exists.  Set gzindex_set_sidecar_mode(
+GZINDEX_SIDECAR_WRITE) to also save it for later processes.
+
 */
 
 
@@ -63,11 +70,25 @@ extern "C" {
 #endif
 #endif
 
+#ifdef HAVE_ZLIB
+struct gzindex_s;
+struct gzindex_reader_s;
+#endif
+
 struct znzptr {
   int withz;
   FILE* nzfptr;
 #ifdef HAVE_ZLIB
   gzFile zfptr;
+
+  /* random access to gzip files opened for reading (see znzseek) */
+  char *zpath;                       /* path, if opened for reading */
+  int zindex_tried;                  /* set once an index was looked for */
+  struct gzindex_s *zindex;          /* access points, a cache reference */
+  struct gzindex_reader_s *zreader;  /* non-NULL once reads use zindex */
+  unsigned char *zdata;              /* compressed file contents */
+  size_t zdata_len;
+  int zdata_mapped;                  /* zdata is mmap()ed, not malloc()ed */
 #endif
 } ;
 
@@ -9,6 +9,8 @@
     4. Timer: class MyTimer, to get elapstime, FPS.  
     5. String operations: Split, GetFullFileName(including extension, get: "aaa.bbb" ), GetFileExtension(get: ".xxx" )
     6. ROS related operations: RosGeoMsgToMatrixS4X4(geometry_msgs::PoseStamped TO 4X4 transform matrix). 
+    7. Memory mapped file: class MappedFile, read-only mapping of a whole file, shared through the page cache. 
+    8. Directories: IsDirectory, ListDirectory(regular files of a directory tree, sorted by path). 
 
     @author: Wenhai Liu
     @version: 1.1 06/02/2020
@@ -23,6 +25,14 @@
 #include <iomanip>
 #include <functional>
 #include <numeric>
+#include <algorithm>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
 #ifdef ROS_VERSION_MAJOR
 #include "ros/ros.h"
 #include "geometry_msgs/PoseStamped.h"
@@ -438,14 +448,151 @@ std::string GetFullFileName(const std::string &Path){
 std::string GetFileExtension(const std::string &Path){
     std::string FullName = GetFullFileName(Path); 
 
+    //names without a dot, e.g. directories, have no extension: 
+    size_t Dot = FullName.find_first_of("."); 
+    if(Dot == std::string::npos){
+        return std::string(); 
+    }
+
     std::string Extension( 
-        FullName.begin() + FullName.find_first_of("."), 
+        FullName.begin() + Dot, 
         FullName.end()
     ); 
 
     return Extension; 
 }
 
+MappedFile::MappedFile(){
+    address = NULL; 
+    length = 0; 
+}
+
+MappedFile::~MappedFile(){
+    Close(); 
+}
+
+bool MappedFile::Open(const std::string &Path){
+#ifndef _WIN32
+    int fd = open(Path.c_str(), O_RDONLY); 
+    if(fd < 0){
+        return false; 
+    }
+
+    //the mapping stays valid after the descriptor is closed: 
+    bool mapped = Open(fd); 
+    close(fd); 
+    return mapped; 
+#else
+    return false; 
+#endif
+}
+
+bool MappedFile::Open(int FileDescriptor){
+    Close(); 
+#ifndef _WIN32
+    struct stat fileStat; 
+    if(fstat(FileDescriptor, &fileStat) != 0 || fileStat.st_size <= 0){
+        return false; 
+    }
+
+    void *mapped = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, FileDescriptor, 0); 
+    if(mapped == MAP_FAILED){
+        return false; 
+    }
+
+    address = mapped; 
+    length = static_cast<size_t>(fileStat.st_size); 
+    return true; 
+#else
+    return false; 
+#endif
+}
+
+void MappedFile::Close(){
+#ifndef _WIN32
+    if(address != NULL){
+        munmap(address, length); 
+    }
+#endif
+    address = NULL; 
+    length = 0; 
+}
+
+bool MappedFile::IsOpen() const{
+    return address != NULL; 
+}
+
+const unsigned char* MappedFile::Data() const{
+    return static_cast<const unsigned char*>(address); 
+}
+
+size_t MappedFile::Size() const{
+    return length; 
+}
+
+bool IsDirectory(const std::string &Path){
+#ifndef _WIN32
+    struct stat PathStat; 
+    return stat(Path.c_str(), &PathStat) == 0 && S_ISDIR(PathStat.st_mode); 
+#else
+    return false; 
+#endif
+}
+
+#ifndef _WIN32
+//appends the files of one directory, subdirectories are walked depth first: 
+static bool AppendDirectory(const std::string &Path, std::vector<std::string> &FilePaths, bool Recursive){
+    DIR *Directory = opendir(Path.c_str()); 
+    if(Directory == NULL){
+        return false; 
+    }
+
+    std::string Prefix = (!Path.empty() && Path[Path.size() - 1] == '/') ? Path : Path + "/"; 
+    for(struct dirent *Item = readdir(Directory); Item != NULL; Item = readdir(Directory)){
+        std::string Name = Item->d_name; 
+        if(Name == "." || Name == ".."){
+            continue; 
+        }
+
+        //the entry type saves a stat per file on most file systems: 
+        std::string ItemPath = Prefix + Name; 
+        bool IsFile = (Item->d_type == DT_REG); 
+        bool IsSubdirectory = (Item->d_type == DT_DIR); 
+        if(Item->d_type == DT_UNKNOWN || Item->d_type == DT_LNK){
+            struct stat ItemStat; 
+            if(stat(ItemPath.c_str(), &ItemStat) != 0){
+                continue; 
+            }
+            IsFile = S_ISREG(ItemStat.st_mode); 
+            //links to directories are not followed, they may form cycles: 
+            IsSubdirectory = S_ISDIR(ItemStat.st_mode) && lstat(ItemPath.c_str(), &ItemStat) == 0 && S_ISDIR(ItemStat.st_mode); 
+        }
+
+        if(IsFile){
+            FilePaths.push_back(ItemPath); 
+        }
+        else if(IsSubdirectory && Recursive){
+            AppendDirectory(ItemPath, FilePaths, Recursive); 
+        }
+    }
+    closedir(Directory); 
+    return true; 
+}
+#endif
+
+bool ListDirectory(const std::string &Path, std::vector<std::string> &FilePaths, bool Recursive){
+    FilePaths.clear(); 
+#ifndef _WIN32
+    if(!AppendDirectory(Path, FilePaths, Recursive)){
+        return false; 
+    }
+    std::sort(FilePaths.begin(), FilePaths.end()); 
+    return true; 
+#else
+    return false; 
+#endif
+}
+
 #ifdef ROS_VERSION_MAJOR
 void RosGeoMsgToMatrixS4X4(const geometry_msgs::PoseStampedConstPtr& RosGeoMsg, std::vector<float>& OutputVector){
 	OutputVector.resize(16, 0.0f); 
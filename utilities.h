@@ -9,6 +9,8 @@
     4. Timer: class MyTimer, to get elapstime, FPS.  
     5. String operations: Split, GetFullFileName(including extension, get: "aaa.bbb" ), GetFileExtension(get: ".xxx" )
     6. ROS related operations: RosGeoMsgToMatrixS4X4(geometry_msgs::PoseStamped TO 4X4 transform matrix). 
+    7. Memory mapped file: class MappedFile, read-only mapping of a whole file, shared through the page cache. 
+    8. Directories: IsDirectory, ListDirectory(regular files of a directory tree, sorted by path). 
 
     @author: Wenhai Liu
     @version: 1.1 06/02/2020
@@ -86,6 +88,33 @@ extern std::vector<std::string> Split(const std::string &s, char delim);
 extern std::string GetFullFileName(const std::string &Path); 
 extern std::string GetFileExtension(const std::string &Path); 
 
+//Read-only memory mapping of a whole file: 
+class MappedFile{
+public:
+    MappedFile(); 
+    ~MappedFile(); 
+
+    bool Open(const std::string &Path); 
+    bool Open(int FileDescriptor); 
+    void Close(); 
+
+    bool IsOpen() const; 
+    const unsigned char* Data() const; 
+    size_t Size() const; 
+
+private:
+    MappedFile(const MappedFile&); 
+    MappedFile& operator=(const MappedFile&); 
+
+    void *address; 
+    size_t length; 
+}; 
+
+//Directories: 
+extern bool IsDirectory(const std::string &Path); 
+//regular files, with Recursive those of the subdirectories too, sorted by path: 
+extern bool ListDirectory(const std::string &Path, std::vector<std::string> &FilePaths, bool Recursive = false); 
+
 #ifdef ROS_VERSION_MAJOR
 
 extern void RosGeoMsgToMatrixS4X4(const geometry_msgs::PoseStampedConstPtr& RosGeoMsg, std::vector<float>& OutputVector);
@@ -0,0 +1,946 @@
+/* gzindex.c -- random access points into a gzip stream held in memory
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#  include <windows.h>
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <unistd.h>
+#  include <pthread.h>
+#endif
+#include "gzindex.h"
+
+#ifndef local
+#  define local static
+#endif
+
+#define WINSIZE 32768U      /* sliding window size */
+#define CHUNK 1073741824U   /* largest avail_in/avail_out handed to inflate */
+
+/* largest amount of the remaining len that fits in an avail_* field */
+local uInt chunk_of(size_t len)
+{
+    return len > CHUNK ? CHUNK : (uInt)len;
+}
+
+/* true if in[pos] starts another gzip member */
+local int member_at(const unsigned char *in, size_t in_len, size_t pos)
+{
+    return pos + 2 <= in_len && in[pos] == 0x1f && in[pos + 1] == 0x8b;
+}
+
+/* Add an access point to the list.  For a point inside a deflate stream,
+   the window is taken from the inflate state in strm. */
+local int add_point(gzindex *index, z_streamp strm, size_t in, size_t out,
+                    int bits, int member)
+{
+    gzindex_point *point;
+
+    if (index->have == index->size) {
+        int size = index->size ? index->size << 1 : 8;
+        gzindex_point *list = (gzindex_point *)realloc(index->list,
+                                                sizeof(gzindex_point) * size);
+        if (list == Z_NULL)
+            return Z_MEM_ERROR;
+        index->list = list;
+        index->size = size;
+    }
+
+    point = index->list + index->have;
+    point->out = out;
+    point->in = in;
+    point->bits = bits;
+    point->member = member;
+    point->window_size = 0;
+    point->window = Z_NULL;
+
+    if (!member && strm != Z_NULL) {
+        uInt have = 0;
+        point->window = (unsigned char *)malloc(WINSIZE);
+        if (point->window == Z_NULL)
+            return Z_MEM_ERROR;
+        inflateGetDictionary(strm, point->window, &have);
+        if (have == 0) {
+            free(point->window);
+            point->window = Z_NULL;
+        }
+        point->window_size = have;
+    }
+
+    index->have++;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+int ZEXPORT gzindex_build(in, in_len, span, out, out_len, built)
+    const unsigned char *in;
+    size_t in_len;
+    size_t span;
+    unsigned char *out;
+    size_t out_len;
+    gzindex **built;
+{
+    z_stream strm;
+    gzindex *index;
+    unsigned char discard[WINSIZE];
+    size_t totout = 0, last = 0, pos;
+    uInt before;
+    int ret;
+
+    if (built == Z_NULL || !member_at(in, in_len, 0))
+        return Z_DATA_ERROR;
+    if (span == 0)
+        span = GZINDEX_SPAN;
+
+    index = (gzindex *)calloc(1, sizeof(gzindex));
+    if (index == Z_NULL)
+        return Z_MEM_ERROR;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.next_in = Z_NULL;
+    strm.avail_in = 0;
+    ret = inflateInit2(&strm, 31);      /* gzip only */
+    if (ret != Z_OK) {
+        free(index);
+        return ret;
+    }
+    strm.next_in = (Bytef *)in;
+
+    /* inflate one deflate block at a time, so that the state can be
+       recorded at the block boundaries */
+    do {
+        if (strm.avail_in == 0) {
+            pos = (size_t)(strm.next_in - in);
+            if (pos >= in_len) {
+                ret = Z_DATA_ERROR;     /* truncated stream */
+                break;
+            }
+            strm.avail_in = chunk_of(in_len - pos);
+        }
+        if (totout < out_len) {
+            strm.next_out = out + totout;
+            strm.avail_out = chunk_of(out_len - totout);
+        }
+        else {
+            strm.next_out = discard;
+            strm.avail_out = WINSIZE;
+        }
+
+        before = strm.avail_out;
+        ret = inflate(&strm, Z_BLOCK);
+        totout += before - strm.avail_out;
+        if (ret == Z_NEED_DICT || ret == Z_BUF_ERROR)
+            ret = Z_DATA_ERROR;
+        if (ret != Z_OK && ret != Z_STREAM_END)
+            break;
+
+        /* at the end of a block that is not the last one of the stream */
+        if ((strm.data_type & 192) == 128 &&
+            (totout == 0 || totout - last >= span)) {
+            ret = add_point(index, &strm, (size_t)(strm.next_in - in), totout,
+                            strm.data_type & 7, 0);
+            if (ret != Z_OK)
+                break;
+            last = totout;
+        }
+
+        /* the trailer is consumed in gzip mode, look for another member */
+        if (ret == Z_STREAM_END &&
+            member_at(in, in_len, (size_t)(strm.next_in - in)))
+            ret = inflateReset2(&strm, 31);
+    } while (ret == Z_OK);
+    inflateEnd(&strm);
+
+    if (ret != Z_STREAM_END) {
+        gzindex_free(index);
+        return ret;
+    }
+
+    index->length = totout;
+    index->in_length = in_len;
+    *built = index;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+int ZEXPORT gzindex_build_bgzf(in, in_len, built)
+    const unsigned char *in;
+    size_t in_len;
+    gzindex **built;
+{
+    gzindex *index;
+    size_t pos = 0, out = 0;
+    int ret = Z_OK;
+
+    if (built == Z_NULL)
+        return Z_DATA_ERROR;
+
+    index = (gzindex *)calloc(1, sizeof(gzindex));
+    if (index == Z_NULL)
+        return Z_MEM_ERROR;
+
+    while (pos < in_len) {
+        size_t xlen, field, bsize = 0;
+        unsigned long isize;
+
+        /* member header with the FEXTRA flag */
+        if (in_len - pos < 18 || !member_at(in, in_len, pos) ||
+            in[pos + 2] != 8 || (in[pos + 3] & 4) == 0) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+
+        /* the BC subfield holds the total member size minus one */
+        xlen = in[pos + 10] | ((size_t)in[pos + 11] << 8);
+        for (field = pos + 12; field + 4 <= pos + 12 + xlen &&
+                               field + 4 <= in_len;) {
+            size_t slen = in[field + 2] | ((size_t)in[field + 3] << 8);
+            if (in[field] == 66 && in[field + 1] == 67 && slen == 2 &&
+                field + 6 <= in_len) {
+                bsize = (in[field + 4] | ((size_t)in[field + 5] << 8)) + 1;
+                break;
+            }
+            field += 4 + slen;
+        }
+        if (bsize < 12 + xlen + 8 || bsize > in_len - pos) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+
+        /* the uncompressed size is in the member trailer */
+        isize = in[pos + bsize - 4] |
+                ((unsigned long)in[pos + bsize - 3] << 8) |
+                ((unsigned long)in[pos + bsize - 2] << 16) |
+                ((unsigned long)in[pos + bsize - 1] << 24);
+        if (isize) {
+            ret = add_point(index, Z_NULL, pos, out, 0, 1);
+            if (ret != Z_OK)
+                break;
+        }
+
+        out += isize;
+        pos += bsize;
+    }
+
+    if (ret != Z_OK || index->have == 0) {
+        gzindex_free(index);
+        return ret != Z_OK ? ret : Z_DATA_ERROR;
+    }
+
+    index->length = out;
+    index->in_length = in_len;
+    *built = index;
+    return Z_OK;
+}
+
+struct gzindex_reader_s {
+    z_stream strm;          /* inflate state, valid if active */
+    const unsigned char *in;
+    size_t in_len;
+    const gzindex *index;
+    size_t pos;             /* offset of the next byte inflated */
+    size_t want;            /* offset of the next byte to return */
+    int active;             /* strm is initialized and positioned at pos */
+    int raw;                /* strm is inflating raw deflate data */
+    int end;                /* the end of the data was reached */
+};
+
+/* Restart inflation at an access point. */
+local int restart(gzindex_reader *reader, const gzindex_point *point)
+{
+    z_streamp strm = &reader->strm;
+    int ret;
+
+    if (reader->active) {
+        inflateEnd(strm);
+        reader->active = 0;
+    }
+
+    strm->zalloc = Z_NULL;
+    strm->zfree = Z_NULL;
+    strm->opaque = Z_NULL;
+    strm->next_in = Z_NULL;
+    strm->avail_in = 0;
+    reader->raw = !point->member;
+    ret = inflateInit2(strm, reader->raw ? -15 : 31);
+    if (ret != Z_OK)
+        return ret;
+    reader->active = 1;
+
+    if (reader->raw) {
+        if (point->bits) {
+            if (point->in == 0)
+                return Z_DATA_ERROR;
+            inflatePrime(strm, point->bits,
+                         reader->in[point->in - 1] >> (8 - point->bits));
+        }
+        if (point->window_size)
+            inflateSetDictionary(strm, point->window, point->window_size);
+    }
+    strm->next_in = (Bytef *)reader->in + point->in;
+    reader->pos = point->out;
+    reader->end = 0;
+    return Z_OK;
+}
+
+/* Inflate up to len bytes at pos into buf, or discard them if buf is
+   Z_NULL.  Returns the number of bytes inflated or a zlib error code. */
+local long long pull(gzindex_reader *reader, unsigned char *buf, size_t len)
+{
+    z_streamp strm = &reader->strm;
+    unsigned char discard[WINSIZE];
+    size_t got = 0, pos;
+    uInt before;
+    int ret;
+
+    while (got < len && !reader->end) {
+        if (strm->avail_in == 0) {
+            pos = (size_t)(strm->next_in - reader->in);
+            if (pos >= reader->in_len)
+                return Z_DATA_ERROR;    /* truncated stream */
+            strm->avail_in = chunk_of(reader->in_len - pos);
+        }
+        if (buf == Z_NULL) {
+            strm->next_out = discard;
+            strm->avail_out = len - got < WINSIZE ? (uInt)(len - got) : WINSIZE;
+        }
+        else {
+            strm->next_out = buf + got;
+            strm->avail_out = chunk_of(len - got);
+        }
+
+        before = strm->avail_out;
+        ret = inflate(strm, Z_NO_FLUSH);
+        got += before - strm->avail_out;
+        reader->pos += before - strm->avail_out;
+
+        if (ret == Z_NEED_DICT)
+            ret = Z_DATA_ERROR;
+        if (ret == Z_MEM_ERROR || ret == Z_DATA_ERROR || ret == Z_STREAM_ERROR)
+            return ret;
+
+        if (ret == Z_STREAM_END) {
+            /* a raw deflate stream leaves the member trailer behind */
+            pos = (size_t)(strm->next_in - reader->in) + (reader->raw ? 8 : 0);
+            if (!member_at(reader->in, reader->in_len, pos)) {
+                reader->end = 1;
+                break;
+            }
+            ret = inflateReset2(strm, 31);
+            if (ret != Z_OK)
+                return ret;
+            reader->raw = 0;
+            strm->next_in = (Bytef *)reader->in + pos;
+            strm->avail_in = 0;
+        }
+    }
+    return (long long)got;
+}
+
+/* ========================================================================= */
+gzindex_reader * ZEXPORT gzindex_open(in, in_len, index)
+    const unsigned char *in;
+    size_t in_len;
+    const gzindex *index;
+{
+    gzindex_reader *reader;
+
+    if (index == Z_NULL || index->have == 0 || in_len < index->in_length)
+        return Z_NULL;
+
+    reader = (gzindex_reader *)calloc(1, sizeof(gzindex_reader));
+    if (reader == Z_NULL)
+        return Z_NULL;
+    reader->in = in;
+    reader->in_len = in_len;
+    reader->index = index;
+    return reader;
+}
+
+/* ========================================================================= */
+void ZEXPORT gzindex_seek(reader, offset)
+    gzindex_reader *reader;
+    size_t offset;
+{
+    if (reader != Z_NULL)
+        reader->want = offset;
+}
+
+/* ========================================================================= */
+size_t ZEXPORT gzindex_tell(reader)
+    const gzindex_reader *reader;
+{
+    return reader == Z_NULL ? 0 : reader->want;
+}
+
+/* ========================================================================= */
+long long ZEXPORT gzindex_read(reader, buf, len)
+    gzindex_reader *reader;
+    unsigned char *buf;
+    size_t len;
+{
+    const gzindex *index;
+    long long got;
+    int lo, hi, ret;
+
+    if (reader == Z_NULL)
+        return Z_STREAM_ERROR;
+    index = reader->index;
+    if (len == 0 || reader->want >= index->length)
+        return 0;
+
+    if (!reader->active || reader->want != reader->pos) {
+        /* last access point at or before the wanted offset */
+        lo = 0;
+        hi = index->have - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) >> 1;
+            if (index->list[mid].out <= reader->want)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+
+        /* restart there unless the current position is at least as close */
+        if (!reader->active || reader->want < reader->pos ||
+            index->list[lo].out > reader->pos) {
+            ret = restart(reader, index->list + lo);
+            if (ret != Z_OK)
+                return ret;
+        }
+
+        got = pull(reader, Z_NULL, reader->want - reader->pos);
+        if (got < 0)
+            return got;
+        if (reader->pos != reader->want)
+            return 0;
+    }
+
+    got = pull(reader, buf, len);
+    if (got > 0)
+        reader->want += (size_t)got;
+    return got;
+}
+
+/* ========================================================================= */
+void ZEXPORT gzindex_close(reader)
+    gzindex_reader *reader;
+{
+    if (reader == Z_NULL)
+        return;
+    if (reader->active)
+        inflateEnd(&reader->strm);
+    free(reader);
+}
+
+/* ========================================================================= */
+long long ZEXPORT gzindex_extract(in, in_len, index, offset, buf, len)
+    const unsigned char *in;
+    size_t in_len;
+    const gzindex *index;
+    size_t offset;
+    unsigned char *buf;
+    size_t len;
+{
+    gzindex_reader *reader;
+    long long got;
+
+    reader = gzindex_open(in, in_len, index);
+    if (reader == Z_NULL)
+        return Z_STREAM_ERROR;
+    gzindex_seek(reader, offset);
+    got = gzindex_read(reader, buf, len);
+    gzindex_close(reader);
+    return got;
+}
+
+/* ========================================================================= */
+void ZEXPORT gzindex_free(index)
+    gzindex *index;
+{
+    int i;
+
+    if (index == Z_NULL)
+        return;
+    for (i = 0; i < index->have; i++)
+        free(index->list[i].window);
+    free(index->list);
+    free(index);
+}
+
+/* Index files are little-endian: the magic, the compressed and uncompressed
+   lengths and the number of points, then for each point its offsets, bits,
+   member flag, window size and the window compressed with compress2. */
+local const unsigned char magic[8] = {'G', 'Z', 'I', 'D', 'X', '1', 0, 0};
+
+local int sidecar_mode = GZINDEX_SIDECAR_READ;
+
+local void put_le(unsigned char *buf, unsigned long long val, int len)
+{
+    int n;
+
+    for (n = 0; n < len; n++, val >>= 8)
+        buf[n] = (unsigned char)val;
+}
+
+local unsigned long long get_le(const unsigned char *buf, int len)
+{
+    unsigned long long val = 0;
+
+    while (len--)
+        val = (val << 8) | buf[len];
+    return val;
+}
+
+/* the sidecar of gzpath, to be freed by the caller */
+local char *sidecar_path(const char *gzpath)
+{
+    size_t len = strlen(gzpath);
+    char *path = (char *)malloc(len + 7);
+
+    if (path != Z_NULL) {
+        memcpy(path, gzpath, len);
+        memcpy(path + len, ".gzidx", 7);
+    }
+    return path;
+}
+
+/* ========================================================================= */
+int ZEXPORT gzindex_save(index, path)
+    const gzindex *index;
+    const char *path;
+{
+    unsigned char head[28], *stored = Z_NULL;
+    char *tmp;
+    FILE *file;
+    uLong bound = compressBound(WINSIZE);
+    int i, ret = Z_OK;
+
+    if (index == Z_NULL || path == Z_NULL)
+        return Z_STREAM_ERROR;
+
+    /* written under a temporary name, so that readers never see half a file */
+    tmp = (char *)malloc(strlen(path) + 32);
+    if (tmp == Z_NULL)
+        return Z_MEM_ERROR;
+    sprintf(tmp, "%s.%ld.tmp", path, (long)getpid());
+    file = fopen(tmp, "wb");
+    if (file == Z_NULL) {
+        free(tmp);
+        return Z_ERRNO;
+    }
+
+    memcpy(head, magic, 8);
+    put_le(head + 8, index->in_length, 8);
+    put_le(head + 16, index->length, 8);
+    put_le(head + 24, (unsigned)index->have, 4);
+    if (fwrite(head, 1, 28, file) != 28)
+        ret = Z_ERRNO;
+
+    stored = (unsigned char *)malloc(bound);
+    if (stored == Z_NULL)
+        ret = Z_MEM_ERROR;
+
+    for (i = 0; i < index->have && ret == Z_OK; i++) {
+        const gzindex_point *point = index->list + i;
+        uLongf stored_size = 0;
+
+        if (point->window_size) {
+            stored_size = bound;
+            ret = compress2(stored, &stored_size, point->window,
+                            point->window_size, Z_BEST_SPEED);
+            if (ret != Z_OK)
+                break;
+        }
+
+        put_le(head, point->out, 8);
+        put_le(head + 8, point->in, 8);
+        head[16] = (unsigned char)point->bits;
+        head[17] = (unsigned char)point->member;
+        put_le(head + 18, point->window_size, 4);
+        put_le(head + 22, stored_size, 4);
+        if (fwrite(head, 1, 26, file) != 26 ||
+            fwrite(stored, 1, stored_size, file) != stored_size)
+            ret = Z_ERRNO;
+    }
+    free(stored);
+
+    if (fclose(file) != 0 && ret == Z_OK)
+        ret = Z_ERRNO;
+#ifdef _WIN32
+    if (ret == Z_OK)
+        remove(path);
+#endif
+    if (ret == Z_OK && rename(tmp, path) != 0)
+        ret = Z_ERRNO;
+    if (ret != Z_OK)
+        remove(tmp);
+    free(tmp);
+    return ret;
+}
+
+/* ========================================================================= */
+int ZEXPORT gzindex_load(path, loaded)
+    const char *path;
+    gzindex **loaded;
+{
+    unsigned char head[28], *stored = Z_NULL;
+    FILE *file;
+    gzindex *index;
+    unsigned long long have;
+    uLong bound = compressBound(WINSIZE);
+    int ret = Z_OK;
+
+    if (path == Z_NULL || loaded == Z_NULL)
+        return Z_STREAM_ERROR;
+    file = fopen(path, "rb");
+    if (file == Z_NULL)
+        return Z_ERRNO;
+
+    if (fread(head, 1, 28, file) != 28 || memcmp(head, magic, 8) != 0) {
+        fclose(file);
+        return Z_DATA_ERROR;
+    }
+    have = get_le(head + 24, 4);
+    if (have == 0 || have > INT_MAX / 2) {
+        fclose(file);
+        return Z_DATA_ERROR;
+    }
+
+    index = (gzindex *)calloc(1, sizeof(gzindex));
+    stored = (unsigned char *)malloc(bound);
+    if (index != Z_NULL)
+        index->list = (gzindex_point *)malloc(sizeof(gzindex_point) *
+                                              (size_t)have);
+    if (index == Z_NULL || index->list == Z_NULL || stored == Z_NULL) {
+        gzindex_free(index);
+        free(stored);
+        fclose(file);
+        return Z_MEM_ERROR;
+    }
+    index->size = (int)have;
+    index->in_length = (size_t)get_le(head + 8, 8);
+    index->length = (size_t)get_le(head + 16, 8);
+
+    while (index->have < index->size) {
+        gzindex_point *point = index->list + index->have;
+        uLongf window_size;
+        uLong stored_size;
+
+        if (fread(head, 1, 26, file) != 26) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        point->out = (size_t)get_le(head, 8);
+        point->in = (size_t)get_le(head + 8, 8);
+        point->bits = head[16];
+        point->member = head[17];
+        point->window_size = (unsigned)get_le(head + 18, 4);
+        point->window = Z_NULL;
+        stored_size = (uLong)get_le(head + 22, 4);
+        index->have++;
+
+        /* offsets must ascend and stay inside the data */
+        if (point->bits > 7 || point->member > 1 ||
+            point->window_size > WINSIZE || stored_size > bound ||
+            (point->window_size == 0) != (stored_size == 0) ||
+            point->in > index->in_length || point->out > index->length ||
+            (index->have > 1 && point->out < point[-1].out) ||
+            (point->bits && point->in == 0)) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        if (point->window_size == 0)
+            continue;
+
+        point->window = (unsigned char *)malloc(WINSIZE);
+        if (point->window == Z_NULL) {
+            ret = Z_MEM_ERROR;
+            break;
+        }
+        window_size = WINSIZE;
+        if (fread(stored, 1, stored_size, file) != stored_size ||
+            uncompress(point->window, &window_size, stored,
+                       stored_size) != Z_OK ||
+            window_size != point->window_size) {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+    }
+    free(stored);
+    fclose(file);
+
+    if (ret != Z_OK) {
+        gzindex_free(index);
+        return ret;
+    }
+    *loaded = index;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+void ZEXPORT gzindex_set_sidecar_mode(mode)
+    int mode;
+{
+    if (mode >= GZINDEX_SIDECAR_OFF && mode <= GZINDEX_SIDECAR_WRITE)
+        sidecar_mode = mode;
+}
+
+/* ========================================================================= */
+int ZEXPORT gzindex_sidecar_mode()
+{
+    return sidecar_mode;
+}
+
+/* ========================================================================= */
+int ZEXPORT gzindex_sidecar_load(gzpath, in_len, loaded)
+    const char *gzpath;
+    size_t in_len;
+    gzindex **loaded;
+{
+    struct stat gzstat, idxstat;
+    gzindex *index;
+    char *path;
+    int ret;
+
+    if (sidecar_mode == GZINDEX_SIDECAR_OFF || gzpath == Z_NULL)
+        return Z_ERRNO;
+    path = sidecar_path(gzpath);
+    if (path == Z_NULL)
+        return Z_MEM_ERROR;
+
+    /* a sidecar older than the gzip file is stale */
+    if (stat(gzpath, &gzstat) != 0 || stat(path, &idxstat) != 0 ||
+        idxstat.st_mtime < gzstat.st_mtime) {
+        free(path);
+        return Z_ERRNO;
+    }
+
+    ret = gzindex_load(path, &index);
+    free(path);
+    if (ret != Z_OK)
+        return ret;
+    if (index->in_length != in_len) {
+        gzindex_free(index);
+        return Z_DATA_ERROR;
+    }
+    *loaded = index;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+int ZEXPORT gzindex_sidecar_save(gzpath, index)
+    const char *gzpath;
+    const gzindex *index;
+{
+    char *path;
+    int ret;
+
+    if (sidecar_mode != GZINDEX_SIDECAR_WRITE || gzpath == Z_NULL)
+        return Z_OK;
+    path = sidecar_path(gzpath);
+    if (path == Z_NULL)
+        return Z_MEM_ERROR;
+    ret = gzindex_save(index, path);
+    free(path);
+    return ret;
+}
+
+/* The cache is a list in order of use, most recent first.  A cached index
+   holds one reference for the cache and one for every caller using it. */
+typedef struct cache_entry_s {
+    char *path;
+    long long mtime;            /* of the gzip file the index was built from */
+    size_t bytes;               /* memory taken by the index */
+    gzindex *index;
+    struct cache_entry_s *next;
+} cache_entry;
+
+local cache_entry *cache_list = Z_NULL;
+local size_t cache_bytes = 0;
+local size_t cache_max = 64UL << 20;
+
+#ifdef _WIN32
+local SRWLOCK cache_mutex = SRWLOCK_INIT;
+#  define CACHE_LOCK() AcquireSRWLockExclusive(&cache_mutex)
+#  define CACHE_UNLOCK() ReleaseSRWLockExclusive(&cache_mutex)
+#else
+local pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#  define CACHE_LOCK() pthread_mutex_lock(&cache_mutex)
+#  define CACHE_UNLOCK() pthread_mutex_unlock(&cache_mutex)
+#endif
+
+/* memory taken by index, its windows included */
+local size_t index_bytes(const gzindex *index)
+{
+    size_t bytes = sizeof(gzindex) + sizeof(gzindex_point) * index->size;
+    int i;
+
+    for (i = 0; i < index->have; i++)
+        if (index->list[i].window != Z_NULL)
+            bytes += WINSIZE;
+    return bytes;
+}
+
+/* drop a reference to index, the last one frees it; under the cache lock */
+local void drop_ref(gzindex *index)
+{
+    if (--index->refs == 0)
+        gzindex_free(index);
+}
+
+/* unlink *link from the cache and drop the cache's reference */
+local void evict(cache_entry **link)
+{
+    cache_entry *entry = *link;
+
+    *link = entry->next;
+    cache_bytes -= entry->bytes;
+    drop_ref(entry->index);
+    free(entry->path);
+    free(entry);
+}
+
+/* evict the least recently used entries until the cache fits the limit */
+local void trim(void)
+{
+    cache_entry **link;
+
+    while (cache_bytes > cache_max) {
+        link = &cache_list;
+        while ((*link)->next != Z_NULL)
+            link = &(*link)->next;
+        evict(link);
+    }
+}
+
+/* modification time of path, or -1 */
+local long long file_mtime(const char *path)
+{
+    struct stat st;
+
+    return stat(path, &st) == 0 ? (long long)st.st_mtime : -1;
+}
+
+/* ========================================================================= */
+gzindex * ZEXPORT gzindex_cache_find(gzpath, in_len)
+    const char *gzpath;
+    size_t in_len;
+{
+    cache_entry **link, *entry;
+    gzindex *index = Z_NULL;
+    long long mtime;
+
+    if (gzpath == Z_NULL)
+        return Z_NULL;
+    mtime = file_mtime(gzpath);
+
+    CACHE_LOCK();
+    for (link = &cache_list; *link != Z_NULL; link = &(*link)->next)
+        if (strcmp((*link)->path, gzpath) == 0)
+            break;
+    entry = *link;
+    if (entry != Z_NULL) {
+        if (entry->mtime != mtime || entry->index->in_length != in_len)
+            evict(link);
+        else {
+            /* move to the front, it is the most recently used now */
+            *link = entry->next;
+            entry->next = cache_list;
+            cache_list = entry;
+            index = entry->index;
+            index->refs++;
+        }
+    }
+    CACHE_UNLOCK();
+    return index;
+}
+
+/* ========================================================================= */
+gzindex * ZEXPORT gzindex_cache_store(gzpath, index)
+    const char *gzpath;
+    gzindex *index;
+{
+    cache_entry **link, *entry;
+
+    if (index == Z_NULL)
+        return Z_NULL;
+    index->refs = 1;
+    if (gzpath == Z_NULL)
+        return index;
+
+    entry = (cache_entry *)calloc(1, sizeof(cache_entry));
+    if (entry != Z_NULL)
+        entry->path = (char *)malloc(strlen(gzpath) + 1);
+    if (entry == Z_NULL || entry->path == Z_NULL) {
+        free(entry);
+        return index;
+    }
+    strcpy(entry->path, gzpath);
+    entry->mtime = file_mtime(gzpath);
+    entry->bytes = index_bytes(index);
+    entry->index = index;
+
+    CACHE_LOCK();
+    if (entry->bytes > cache_max) {
+        CACHE_UNLOCK();
+        free(entry->path);
+        free(entry);
+        return index;
+    }
+
+    /* an index of the same file stored meanwhile is replaced */
+    for (link = &cache_list; *link != Z_NULL; link = &(*link)->next)
+        if (strcmp((*link)->path, gzpath) == 0) {
+            evict(link);
+            break;
+        }
+    index->refs++;
+    entry->next = cache_list;
+    cache_list = entry;
+    cache_bytes += entry->bytes;
+    trim();
+    CACHE_UNLOCK();
+    return index;
+}
+
+/* ========================================================================= */
+void ZEXPORT gzindex_cache_release(index)
+    gzindex *index;
+{
+    if (index == Z_NULL)
+        return;
+    CACHE_LOCK();
+    drop_ref(index);
+    CACHE_UNLOCK();
+}
+
+/* ========================================================================= */
+void ZEXPORT gzindex_set_cache_limit(bytes)
+    size_t bytes;
+{
+    CACHE_LOCK();
+    cache_max = bytes;
+    trim();
+    CACHE_UNLOCK();
+}
+
+/* ========================================================================= */
+size_t ZEXPORT gzindex_cache_limit()
+{
+    size_t bytes;
+
+    CACHE_LOCK();
+    bytes = cache_max;
+    CACHE_UNLOCK();
+    return bytes;
+}
@@ -0,0 +1,144 @@
+/* gzindex.h -- random access points into a gzip stream held in memory
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ *
+ * Based on the approach of examples/zran.c: while a gzip stream is inflated
+ * once, the inflate state is recorded at deflate block boundaries roughly
+ * every span bytes of output (the bit offset into the compressed data and
+ * the 32K of uncompressed data preceding it).  From any of these access
+ * points inflation can be restarted without decoding what comes before, so
+ * independent ranges of the output can be inflated concurrently, and small
+ * ranges can be extracted without inflating from the start of the stream.
+ *
+ * Concatenated gzip members are supported.  For BGZF files (bgzip, htslib),
+ * every member is an access point by itself, and the index is read from the
+ * member headers without inflating anything.
+ *
+ * An index can be saved next to the gzip file as a sidecar (<file>.gzidx),
+ * so that later processes get random access without the indexing pass.
+ */
+
+#ifndef GZINDEX_H
+#define GZINDEX_H
+
+#include <stddef.h>
+#include "zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* default distance between access points, in uncompressed bytes */
+#define GZINDEX_SPAN 1048576
+
+typedef struct gzindex_point_s {
+    size_t out;             /* offset of the access point in the output */
+    size_t in;              /* offset of the first full byte in the input */
+    int bits;               /* number of bits (1-7) taken from in[in - 1] */
+    int member;             /* 1 if in points at a gzip member header */
+    unsigned window_size;   /* bytes of dictionary in window */
+    unsigned char *window;  /* preceding uncompressed data, or Z_NULL */
+} gzindex_point;
+
+typedef struct gzindex_s {
+    int have;               /* number of access points in list */
+    int size;               /* number of access points allocated */
+    size_t length;          /* total length of the uncompressed data */
+    size_t in_length;       /* length of the compressed data indexed */
+    gzindex_point *list;    /* access points, ascending in out */
+    int refs;               /* holders of a cached index, see below */
+} gzindex;
+
+/* Inflate the gzip stream in[0..in_len-1] from start to end, recording an
+   access point about every span bytes of output.  The first out_len bytes
+   of the uncompressed data are written to out (out may be Z_NULL when
+   out_len is 0), the rest is inflated and discarded.  On success *built is
+   the new index and Z_OK is returned, otherwise a zlib error code. */
+ZEXTERN int ZEXPORT gzindex_build OF((const unsigned char *in, size_t in_len,
+                                      size_t span, unsigned char *out,
+                                      size_t out_len, gzindex **built));
+
+/* Build the index of a BGZF file from its member headers, without
+   inflating.  Returns Z_DATA_ERROR if the data is not BGZF. */
+ZEXTERN int ZEXPORT gzindex_build_bgzf OF((const unsigned char *in,
+                                           size_t in_len, gzindex **built));
+
+/* Inflate len bytes starting at offset of the uncompressed data into buf,
+   starting from the closest access point at or before offset.  Returns the
+   number of bytes written, which is less than len only at the end of the
+   data, or a negative zlib error code. */
+ZEXTERN long long ZEXPORT gzindex_extract OF((const unsigned char *in,
+                                              size_t in_len,
+                                              const gzindex *index,
+                                              size_t offset,
+                                              unsigned char *buf,
+                                              size_t len));
+
+ZEXTERN void ZEXPORT gzindex_free OF((gzindex *index));
+
+/* Sequential reader over indexed data, for callers that seek and read in
+   small pieces.  A seek restarts inflation from the closest access point
+   unless reading on from the current position is not further; the seek
+   itself is deferred to the next read. */
+typedef struct gzindex_reader_s gzindex_reader;
+
+ZEXTERN gzindex_reader * ZEXPORT gzindex_open OF((const unsigned char *in,
+                                                  size_t in_len,
+                                                  const gzindex *index));
+ZEXTERN void ZEXPORT gzindex_seek OF((gzindex_reader *reader, size_t offset));
+ZEXTERN size_t ZEXPORT gzindex_tell OF((const gzindex_reader *reader));
+
+/* Returns the number of bytes read, less than len only at the end of the
+   data, or a negative zlib error code. */
+ZEXTERN long long ZEXPORT gzindex_read OF((gzindex_reader *reader,
+                                           unsigned char *buf, size_t len));
+ZEXTERN void ZEXPORT gzindex_close OF((gzindex_reader *reader));
+
+/* Write the index to path, or read one back.  Both return Z_OK on success,
+   Z_ERRNO on a file error and Z_DATA_ERROR for an invalid index file. */
+ZEXTERN int ZEXPORT gzindex_save OF((const gzindex *index, const char *path));
+ZEXTERN int ZEXPORT gzindex_load OF((const char *path, gzindex **loaded));
+
+/* Use of sidecar index files, process wide: */
+#define GZINDEX_SIDECAR_OFF   0     /* never touch sidecars */
+#define GZINDEX_SIDECAR_READ  1     /* use existing sidecars (default) */
+#define GZINDEX_SIDECAR_WRITE 2     /* also write a sidecar once indexed */
+
+ZEXTERN void ZEXPORT gzindex_set_sidecar_mode OF((int mode));
+ZEXTERN int ZEXPORT gzindex_sidecar_mode OF((void));
+
+/* Load the sidecar of the gzip file gzpath, whose compressed size is in_len.
+   A sidecar older than the gzip file, or of a different length, is stale
+   and ignored.  Returns Z_OK when *loaded was set. */
+ZEXTERN int ZEXPORT gzindex_sidecar_load OF((const char *gzpath,
+                                             size_t in_len,
+                                             gzindex **loaded));
+
+/* Save the sidecar of gzpath, if the sidecar mode allows writing. */
+ZEXTERN int ZEXPORT gzindex_sidecar_save OF((const char *gzpath,
+                                             const gzindex *index));
+
+/* Process wide cache of indices in memory, shared by all readers of a gzip
+   file in the process.  Entries are keyed on the path, and are stale once
+   the compressed length or the modification time of the file changes.  The
+   least recently used indices are dropped while the cached ones take more
+   than the limit in bytes (64 MB by default, 0 disables the cache).
+
+   gzindex_cache_find returns the current index of gzpath, whose compressed
+   size is in_len, or Z_NULL.  gzindex_cache_store hands a new index over to
+   the cache, which may drop it right away.  Both give the caller a reference
+   to the index, to be dropped with gzindex_cache_release instead of
+   gzindex_free. */
+ZEXTERN gzindex * ZEXPORT gzindex_cache_find OF((const char *gzpath,
+                                                 size_t in_len));
+ZEXTERN gzindex * ZEXPORT gzindex_cache_store OF((const char *gzpath,
+                                                  gzindex *index));
+ZEXTERN void ZEXPORT gzindex_cache_release OF((gzindex *index));
+
+ZEXTERN void ZEXPORT gzindex_set_cache_limit OF((size_t bytes));
+ZEXTERN size_t ZEXPORT gzindex_cache_limit OF((void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GZINDEX_H */